@@ -5,11 +5,10 @@ namespace flare32
 
 Assembler::Assembler() 
 	: __we(&__line_num),
-	__lexer(&__we, &__builtin_sym_tbl, &__user_sym_tbl, &__define_tbl, 
-	&__instr_tbl),
-	__codegen(&__we, &__addr, &__last_addr, &__pass, last_pass,
-	&__builtin_sym_tbl, &__user_sym_tbl, &__define_tbl, &__instr_tbl,
-	&__options)
+	__lexer(&__we, &__define_tbl, &__instr_tbl),
+	__codegen(&__we, &__addr, &__last_addr, &__pass, first_output_pass,
+	&__user_sym_tbl, &__define_tbl, &__instr_tbl, &__options,
+	&__output_buf)
 {
 }
 void Assembler::init(int s_argc, char** s_argv)
@@ -19,6 +18,14 @@ void Assembler::init(int s_argc, char** s_argv)
 
 
 	set_input_filename(parse_argv());
+
+	// Each batch file gets opened by the Assembler that assembles it, and
+	// object files get opened by the Linker
+	if (__options.batch || __options.link)
+	{
+		return;
+	}
+
 	set_infile(fopen(input_filename(), "r"));
 
 	if (infile() == nullptr)
@@ -27,14 +34,104 @@ void Assembler::init(int s_argc, char** s_argv)
 	}
 
 	__lexer.set_infile(infile());
-
-	fill_builtin_sym_tbl();
 }
 
 int Assembler::operator () ()
+{
+	if (__options.batch)
+	{
+		return batch();
+	}
+
+	if (__options.link)
+	{
+		Linker linker(&__we);
+		linker.link(__input_filenames, __output_buf);
+		__output_buf.flush(stdout, __options.out_type);
+
+		return 0;
+	}
+
+	__assemble_and_write([]() -> FILE* { return stdout; });
+
+	return 0;
+}
+
+void Assembler::__assemble_and_write
+	(const std::function<FILE*()>& some_open_outfile)
+{
+	if (__options.cache_dir.empty())
+	{
+		assemble();
+		__write_output(some_open_outfile());
+		return;
+	}
+
+	// The file is only read once, since it might not be possible to go
+	// back and read it again (e.g. a pipe)
+	std::string source;
+	read_input(source);
+
+	const BuildCache build_cache(__options.cache_dir);
+	std::string output;
+
+	if (build_cache.find(source, __options, output))
+	{
+		FILE* outfile = some_open_outfile();
+		fwrite(output.data(), 1, output.size(), outfile);
+		fflush(outfile);
+		return;
+	}
+
+	assemble(std::move(source));
+
+	// The output gets written to a temporary file, so that it can be
+	// stored as well
+	FILE* temp_file = tmpfile();
+
+	if (temp_file == nullptr)
+	{
+		__write_output(some_open_outfile());
+		return;
+	}
+
+	__write_output(temp_file);
+	rewind(temp_file);
+	read_whole_file(temp_file, output);
+	fclose(temp_file);
+
+	FILE* outfile = some_open_outfile();
+	fwrite(output.data(), 1, output.size(), outfile);
+	fflush(outfile);
+
+	// Not being able to store it just means that it gets assembled again
+	// next time
+	build_cache.store(__input, __options, output);
+}
+
+void Assembler::__write_output(FILE* some_outfile)
+{
+	if (__options.object)
+	{
+		write_object(some_outfile);
+	}
+	else
+	{
+		__output_buf.flush(some_outfile, __options.out_type);
+	}
+}
+
+void Assembler::assemble()
+{
+	std::string input;
+	read_input(input);
+	assemble(std::move(input));
+}
+
+void Assembler::assemble(std::string&& some_input)
 {
 	set_pass(0);
-	fill_lines();
+	fill_lines(std::move(some_input));
 
 	//{
 	//reinit();
@@ -44,349 +141,1577 @@ int Assembler::operator () ()
 	//}
 
 
-	// Two passes
-	for (set_pass(1); pass() <= last_pass; set_pass(pass() + 1))
+	if (__options.single_pass)
 	{
-		reinit();
+		single_pass();
+	}
+	else
+	{
+		multi_pass();
+	}
 
-		size_t outer_index = 0, inner_index = 0;
+	// Checked before anything gets written, so that an error never leaves
+	// an empty object file behind
+	if (__options.object)
+	{
+		check_global_syms();
+	}
+}
 
-		//advance(outer_index, inner_index, true);
-		lex(outer_index, inner_index, true);
+int Assembler::batch()
+{
+	std::vector<std::string> errors(__input_filenames.size());
+
+	// Every file gets assembled on one thread, so that the threads are
+	// only ever split up between files.  A big file can't hold up the
+	// rest, since whichever threads finish their own files first steal
+	// the files that haven't been started yet.
+	WorkStealingPool pool(num_threads());
+
+	pool.run(__input_filenames.size(), [&](size_t i) -> void
+	{
+		Assembler file_asm;
+		file_asm.__assemble_batch_file(*this, __input_filenames[i],
+			errors[i]);
+	});
+
+	// Errors are reported in the same order as the input files, no matter
+	// which thread got to which file first
+	int ret = 0;
+
+	for (size_t i=0; i<errors.size(); ++i)
+	{
+		if (!errors[i].empty())
+		{
+			printerr(__input_filenames[i], ":  ", errors[i]);
+			ret = 1;
+		}
+	}
+
+	return ret;
+}
+
+void Assembler::__assemble_batch_file(const Assembler& some_main,
+	std::string& some_filename, std::string& ret_error)
+{
+	__we.defer();
+	__options = some_main.__options;
+	__options.batch = false;
+	__options.num_threads = 1;
+
+	// If there's an error after the output file was opened, it gets
+	// removed, rather than being left there empty or partly written
+	std::FILE* outfile = nullptr;
+	std::string out_filename;
+
+	auto discard_output = [&]() -> void
+	{
+		if (outfile != nullptr)
+		{
+			fclose(outfile);
+			std::remove(out_filename.c_str());
+			outfile = nullptr;
+		}
+	};
+
+	try
+	{
+		set_input_filename(some_filename.data());
+		set_infile(fopen(input_filename(), "r"));
+
+		if (infile() == nullptr)
+		{
+			err("Cannot read file");
+		}
+
+		__lexer.set_infile(infile());
+
+		__assemble_and_write([&]() -> FILE*
+		{
+			out_filename = batch_output_filename(some_filename, __options);
+			outfile = fopen(out_filename.c_str(), "wb");
+
+			if (outfile == nullptr)
+			{
+				we().fail("Error:  Cannot write file \"", out_filename,
+					"\"\n");
+			}
+
+			return outfile;
+		});
+		fclose(outfile);
+		outfile = nullptr;
+	}
+	catch (const WarnError::Deferred&)
+	{
+		discard_output();
+		ret_error = we().deferred_msg();
+	}
+
+	// Anything else (e.g. std::out_of_range from malformed input) would
+	// otherwise take every other file down with it
+	catch (const std::exception& e)
+	{
+		discard_output();
+		ret_error = sconcat("Error, On line ", line_num(), ":  ",
+			e.what(), "\n");
+	}
+
+	if (infile() != nullptr)
+	{
+		fclose(infile());
+		set_infile(nullptr);
+	}
+}
+
+std::string Assembler::batch_output_filename
+	(const std::string& some_input_filename, const Options& some_options)
+{
+	std::string ext;
+
+	switch (some_options.out_type)
+	{
+	case OutType::Orig:
+		ext = ".orig";
+		break;
+	case OutType::Binary:
+		ext = ".bin";
+		break;
+	case OutType::IntelHex:
+		ext = ".ihex";
+		break;
+	case OutType::SRecord:
+		ext = ".srec";
+		break;
+	}
+
+	if (some_options.object)
+	{
+		ext = ".obj";
+	}
+
+	// Replace the extension, if there is one
+	const size_t slash_pos = some_input_filename.rfind('/');
+	const size_t dot_pos = some_input_filename.rfind('.');
+	const size_t base_pos = (slash_pos == std::string::npos) ? 0
+		: (slash_pos + 1);
+	std::string ret = some_input_filename;
+
+	if ((dot_pos != std::string::npos) && (dot_pos > base_pos))
+	{
+		ret.resize(dot_pos);
+	}
+
+	ret += ext;
+
+	// Never overwrite the input file
+	if (ret == some_input_filename)
+	{
+		ret += ext;
+	}
+
+	return ret;
+}
+
+void Assembler::multi_pass()
+{
+	auto size_line = [&](size_t i) -> void
+	{
+		const auto& lexed_line = __lexed_lines[i];
+
+		if (i >= __line_addrs.size())
+		{
+			__line_addrs.resize(i + 1);
+		}
 
-		while (next_tok() != &Tok::Eof)
+		__line_addrs[i] = addr();
+		set_line_num(lexed_line.line_num);
+
+		if (!__size_cached_line(i))
+		{
+			line(parse_span(lexed_line));
+		}
+	};
+
+	// With -i, if there's a cache from last time, the whole file gets
+	// lexed before the first pass, so that its lines can be matched up
+	// with the cached ones
+	const bool lexed_early = (__options.incremental
+		&& __icache.read(icache_filename()));
+
+	if (lexed_early)
+	{
+		lex_lines([](size_t) -> void {});
+		__match_icache();
+	}
+
+	// Keep going until label values stop changing
+	for (s32 num_passes=1; ; ++num_passes)
+	{
+		reinit();
+		set_pass(1);
+		__defined_syms.clear();
+		__found_redefinition = false;
+
+		// The file is only lexed once, during the first pass
+		if ((num_passes == 1) && !lexed_early)
 		{
-			line(outer_index, inner_index);
+			lex_lines(size_line);
+		}
+		else
+		{
+			for (size_t i=0; i<__lexed_lines.size(); ++i)
+			{
+				size_line(i);
+			}
 		}
 
 		//printout("\n\n");
+
+		update_changed();
+
+		if ((num_passes > 1) && !changed())
+		{
+			break;
+		}
+
+		if (num_passes >= max_passes)
+		{
+			we().fail("Error:  Label values still changing after ",
+				max_passes, " passes\n");
+		}
 	}
 
-	return 0;
+	output_pass();
 }
 
+void Assembler::output_pass()
+{
+	reinit();
+	set_pass(first_output_pass);
+
+	// Every line now starts at the same address it did in the last pass,
+	// so the lines can be split up between threads.  That doesn't work if
+	// a symbol gets redefined partway through, though.
+	const size_t num_chunks = std::min(num_threads(), 
+		__lexed_lines.size() / min_lines_per_thread);
 
-char* Assembler::parse_argv()
+	if (__options.incremental)
+	{
+		__incremental_output_pass();
+		return;
+	}
+
+	if ((num_chunks > 1) && !__found_redefinition)
+	{
+		parallel_output_pass(num_chunks);
+		return;
+	}
+
+	for (const auto& lexed_line : __lexed_lines)
+	{
+		set_line_num(lexed_line.line_num);
+		line(parse_span(lexed_line));
+	}
+}
+
+void Assembler::__incremental_output_pass()
 {
-	if (argc() != 2)
+	if (__line_hashes.size() != __lexed_lines.size())
 	{
-		printerr("Usage:  ", argv()[0], " input_file\n");
-		exit(1);
+		__hash_lines();
+	}
+
+	// The symbol values that the cache gets checked against are the ones
+	// from the end of the output pass, which are only the values that
+	// lines used if nothing was redefined.  Labels getting defined again
+	// in this pass count as redefinitions too, so check before that.
+	const bool found_redefinition = __found_redefinition;
+	__reuse_cached_bytes = (!found_redefinition
+		&& !__icache.found_redefinition);
+
+	__new_icache.clear();
+	__new_icache.found_redefinition = found_redefinition;
+
+	std::vector<u8> data;
+	std::vector<u32> item_ends;
+
+	for (size_t i=0; i<__lexed_lines.size(); ++i)
+	{
+		const auto& lexed_line = __lexed_lines[i];
+		set_line_num(lexed_line.line_num);
+
+		const size_t line_addr = addr();
+		const OutputBuffer::Mark mark = __output_buf.mark();
+
+		if (!__gen_cached_line(i))
+		{
+			line(parse_span(lexed_line));
+		}
+
+		const bool reusable = __output_buf.since_mark(mark, data,
+			item_ends);
+		__new_icache.add_line(__line_hashes[i], reusable, line_addr, data,
+			item_ends);
+	}
+
+	for (const auto& sym : user_sym_tbl().symbols())
+	{
+		__new_icache.syms.push_back(std::pair<std::string, s64>
+			(__lexer.ident_pool().str(sym.id()), sym.value()));
 	}
 
-	return argv()[1];
+	// Not being able to write the cache just means that next time
+	// everything gets assembled again
+	__new_icache.write(icache_filename());
 }
 
-void Assembler::reinit()
+void Assembler::__hash_lines()
 {
-	rewind(infile());
-	set_addr(0);
-	set_line_num(0);
-	set_next_char(' ');
-	__prev_tok = nullptr;
-	set_next_tok(nullptr);
-	set_next_sym_str("");
-	set_next_num(-1);
+	__line_hashes.resize(__lexed_lines.size());
+
+	for (size_t i=0; i<__lexed_lines.size(); ++i)
+	{
+		__line_hashes[i] = IncrementalCache::hash_line
+			(parse_span(__lexed_lines[i]), __lexer.ident_pool());
+	}
+}
+
+void Assembler::__match_icache()
+{
+	__hash_lines();
+
+	const size_t num_lines = __lexed_lines.size(),
+		num_cached = __icache.lines.size(),
+		max_matched = std::min(num_lines, num_cached);
+
+	__cached_line_indices.assign(num_lines, no_cached_line);
+
+	size_t prefix = 0;
+
+	while ((prefix < max_matched)
+		&& (__line_hashes[prefix] == __icache.lines[prefix].hash))
+	{
+		__cached_line_indices[prefix] = prefix;
+		++prefix;
+	}
+
+	for (size_t suffix=1; (prefix + suffix) <= max_matched; ++suffix)
+	{
+		const size_t i = num_lines - suffix, j = num_cached - suffix;
+
+		if (__line_hashes[i] != __icache.lines[j].hash)
+		{
+			break;
+		}
+
+		__cached_line_indices[i] = j;
+	}
+
+	const size_t num_ids = __lexer.ident_pool().size();
+	__cached_sym_defined.assign(num_ids, false);
+	__cached_sym_values.assign(num_ids, 0);
+
+	for (const auto& sym : __icache.syms)
+	{
+		const SymId sym_id = __lexer.ident_pool().find(sym.first);
+
+		// Anything that isn't in the ident pool can't be used by any line
+		if (sym_id < num_ids)
+		{
+			__cached_sym_defined[sym_id] = true;
+			__cached_sym_values[sym_id] = sym.second;
+		}
+	}
+}
+
+const IncrementalCache::Line* Assembler::__cached_line(size_t some_index)
+	const
+{
+	if ((some_index >= __cached_line_indices.size())
+		|| (__cached_line_indices[some_index] == no_cached_line))
+	{
+		return nullptr;
+	}
+
+	const auto& cached = __icache.lines[__cached_line_indices[some_index]];
+
+	if (!cached.reusable)
+	{
+		return nullptr;
+	}
+
+	const ParseSpan parse_vec = parse_span(__lexed_lines[some_index]);
+	const size_t first_index = line_has_label(parse_vec) ? 2 : 0;
+
+	if (first_index >= parse_vec.size())
+	{
+		return &cached;
+	}
+
+	const ParseNode& node = parse_vec[first_index];
+
+	if (tok_is_comment(node) || (node.next_tok_kind == TokKind::Instr)
+		|| (node.next_tok_kind == TokKind::DotB)
+		|| (node.next_tok_kind == TokKind::DotW))
+	{
+		return &cached;
+	}
+
+	return nullptr;
+}
+
+bool Assembler::__cached_sym_unchanged(SymId some_sym_id) const
+{
+	const bool was_defined = ((some_sym_id < __cached_sym_defined.size())
+		&& __cached_sym_defined[some_sym_id]);
+	const Symbol* sym = __user_sym_tbl.find(some_sym_id);
+
+	if (sym == nullptr)
+	{
+		return !was_defined;
+	}
+
+	return (was_defined
+		&& (__cached_sym_values[some_sym_id] == sym->value()));
 }
 
-void Assembler::fill_builtin_sym_tbl()
+bool Assembler::__size_cached_line(size_t some_index)
 {
-	// General-purpose registers
-	builtin_sym_tbl().insert_or_assign(Symbol("r0", &Tok::Reg, 0));
-	builtin_sym_tbl().insert_or_assign(Symbol("r1", &Tok::Reg, 1));
-	builtin_sym_tbl().insert_or_assign(Symbol("r2", &Tok::Reg, 2));
-	builtin_sym_tbl().insert_or_assign(Symbol("r3", &Tok::Reg, 3));
-	builtin_sym_tbl().insert_or_assign(Symbol("r4", &Tok::Reg, 4));
-	builtin_sym_tbl().insert_or_assign(Symbol("r5", &Tok::Reg, 5));
-	builtin_sym_tbl().insert_or_assign(Symbol("r6", &Tok::Reg, 6));
-	builtin_sym_tbl().insert_or_assign(Symbol("r7", &Tok::Reg, 7));
-	builtin_sym_tbl().insert_or_assign(Symbol("r8", &Tok::Reg, 8));
-	builtin_sym_tbl().insert_or_assign(Symbol("r9", &Tok::Reg, 9));
-	builtin_sym_tbl().insert_or_assign(Symbol("r10", &Tok::Reg, 10));
-	builtin_sym_tbl().insert_or_assign(Symbol("r11", &Tok::Reg, 11));
-	builtin_sym_tbl().insert_or_assign(Symbol("r12", &Tok::Reg, 12));
-	builtin_sym_tbl().insert_or_assign(Symbol("r13", &Tok::Reg, 13));
-	builtin_sym_tbl().insert_or_assign(Symbol("r14", &Tok::Reg, 14));
-	builtin_sym_tbl().insert_or_assign(Symbol("r15", &Tok::Reg, 15));
-	builtin_sym_tbl().insert_or_assign(Symbol("lr", &Tok::Reg, 14));
-	builtin_sym_tbl().insert_or_assign(Symbol("sp", &Tok::Reg, 15));
+	const IncrementalCache::Line* cached = __cached_line(some_index);
+
+	if (cached == nullptr)
+	{
+		return false;
+	}
+
+	handle_label(parse_span(__lexed_lines[some_index]));
+
+	if (cached->size != 0)
+	{
+		set_last_addr(set_addr(addr() + cached->size));
+	}
 
-	// Special-purpose registers
-	builtin_sym_tbl().insert_or_assign(Symbol("pc", &Tok::RegPc, -1));
-	builtin_sym_tbl().insert_or_assign(Symbol("Ira", &Tok::RegIra, -1));
-	builtin_sym_tbl().insert_or_assign(Symbol("Flags", &Tok::RegFlags,
-		-1));
+	return true;
+}
 
+bool Assembler::__gen_cached_line(size_t some_index)
+{
+	const IncrementalCache::Line* cached = __cached_line(some_index);
 
-	// Instructions
-	for (const auto& outer_iter : __instr_tbl.instr_vec)
+	if (!__reuse_cached_bytes || (cached == nullptr)
+		|| (cached->addr != addr()))
 	{
-		for (const auto& instr : *outer_iter)
+		return false;
+	}
+
+	// Any symbol the line uses might have a different value now
+	const ParseSpan parse_vec = parse_span(__lexed_lines[some_index]);
+
+	for (size_t i=(line_has_label(parse_vec) ? 2 : 0);
+		i<parse_vec.size();
+		++i)
+	{
+		if (tok_is_ident_ish(parse_vec[i])
+			&& !__cached_sym_unchanged(parse_vec[i].next_sym_id))
+		{
+			return false;
+		}
+	}
+
+	handle_label(parse_vec);
+
+	__output_buf.gen(addr(), __icache.data.data() + cached->first_data,
+		cached->size, __icache.item_ends.data() + cached->first_item_end,
+		cached->num_item_ends);
+
+	if (cached->size != 0)
+	{
+		set_last_addr(set_addr(addr() + cached->size));
+	}
+
+	return true;
+}
+
+void Assembler::parallel_output_pass(size_t num_chunks)
+{
+	// std::deque because an Assembler can't be moved
+	std::deque<Assembler> workers(num_chunks);
+	std::vector<std::exception_ptr> errors(num_chunks);
+	std::vector<std::thread> threads;
+
+	for (size_t i=0; i<num_chunks; ++i)
+	{
+		workers[i].__init_worker(*this);
+	}
+
+	for (size_t i=0; i<num_chunks; ++i)
+	{
+		threads.push_back(std::thread([&, i]() -> void
+		{
+			try
+			{
+				workers[i].__assemble_chunk(*this,
+					(__lexed_lines.size() * i) / num_chunks,
+					(__lexed_lines.size() * (i + 1)) / num_chunks);
+			}
+			catch (...)
+			{
+				errors[i] = std::current_exception();
+			}
+		}));
+	}
+
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+
+	// The first error in the file is the one that gets reported, same as
+	// if there were only one thread
+	for (size_t i=0; i<num_chunks; ++i)
+	{
+		if (errors[i] == nullptr)
+		{
+			__output_buf.append(std::move(workers[i].__output_buf));
+			set_addr(workers[i].addr());
+			set_last_addr(workers[i].last_addr());
+			continue;
+		}
+
+		try
+		{
+			std::rethrow_exception(errors[i]);
+		}
+		catch (const WarnError::Deferred&)
+		{
+			we().fail(workers[i].we().deferred_msg());
+		}
+	}
+}
+
+void Assembler::__init_worker(const Assembler& some_main)
+{
+	__we.defer();
+	__options = some_main.__options;
+	__user_sym_tbl = some_main.__user_sym_tbl;
+	__define_tbl = some_main.__define_tbl;
+	__instr_by_signature = some_main.__instr_by_signature;
+	__defined_syms = some_main.__defined_syms;
+	set_pass(some_main.pass());
+}
+
+void Assembler::__assemble_chunk(const Assembler& some_main,
+	size_t some_begin, size_t some_end)
+{
+	if (some_begin >= some_end)
+	{
+		return;
+	}
+
+	set_addr(some_main.__line_addrs[some_begin]);
+
+	for (size_t i=some_begin; i<some_end; ++i)
+	{
+		const auto& lexed_line = some_main.__lexed_lines[i];
+
+		set_line_num(lexed_line.line_num);
+		line(some_main.parse_span(lexed_line));
+	}
+}
+
+
+char* Assembler::parse_argv()
+{
+	auto usage = [&]() -> void
+	{
+		printerr("Usage:  ", argv()[0], " [-1|-i] [-j num_threads] ",
+			"[-C cache_dir] [-f orig|bin|ihex|srec] [-c] input_file\n",
+			"        ", argv()[0], " -b [-1|-i] [-j num_threads] ",
+			"[-C cache_dir] [-f orig|bin|ihex|srec] [-c] ",
+			"input_file|@list_file...\n",
+			"        ", argv()[0], " -l [-f orig|bin|ihex|srec] ",
+			"object_file|@list_file...\n");
+		exit(1);
+	};
+
+	char* ret = nullptr;
+	size_t num_inputs = 0;
+
+	for (int i=1; i<argc(); ++i)
+	{
+		const std::string arg = argv()[i];
+
+		// Single-pass mode
+		if (arg == "-1")
+		{
+			__options.single_pass = true;
+		}
+
+		// Incremental mode
+		else if (arg == "-i")
+		{
+			__options.incremental = true;
+		}
+
+		// How many threads to use
+		else if (arg == "-j")
+		{
+			if ((++i) >= argc())
+			{
+				usage();
+			}
+
+			char* end = nullptr;
+			const unsigned long num_threads = strtoul(argv()[i], &end, 10);
+
+			if ((end == argv()[i]) || (*end != '\0') || (num_threads == 0))
+			{
+				usage();
+			}
+
+			__options.num_threads = num_threads;
+		}
+
+		// Build cache directory
+		else if (arg == "-C")
+		{
+			if (((++i) >= argc()) || (*argv()[i] == '\0'))
+			{
+				usage();
+			}
+
+			__options.cache_dir = argv()[i];
+		}
+
+		// Output format
+		else if (arg == "-f")
+		{
+			if ((++i) >= argc())
+			{
+				usage();
+			}
+
+			const std::string format = argv()[i];
+
+			if (format == "orig")
+			{
+				__options.out_type = OutType::Orig;
+			}
+			else if (format == "bin")
+			{
+				__options.out_type = OutType::Binary;
+			}
+			else if (format == "ihex")
+			{
+				__options.out_type = OutType::IntelHex;
+			}
+			else if (format == "srec")
+			{
+				__options.out_type = OutType::SRecord;
+			}
+			else
+			{
+				usage();
+			}
+		}
+
+		// Batch mode
+		else if (arg == "-b")
+		{
+			__options.batch = true;
+		}
+
+		// Write an object file
+		else if (arg == "-c")
+		{
+			__options.object = true;
+		}
+
+		// Link object files
+		else if (arg == "-l")
+		{
+			__options.link = true;
+		}
+
+		// A file listing input files (only allowed in batch and link mode)
+		else if ((arg.size() > 1) && (arg.front() == '@'))
+		{
+			std::ifstream list_file(arg.substr(1));
+
+			if (!list_file.is_open())
+			{
+				printerr("Error:  Cannot read file \"", arg.substr(1),
+					"\"\n");
+				exit(1);
+			}
+
+			std::string filename;
+
+			while (list_file >> filename)
+			{
+				__input_filenames.push_back(filename);
+			}
+
+			// Can't be used as the one input file outside of batch and
+			// link mode
+			num_inputs += 2;
+		}
+		else
+		{
+			ret = argv()[i];
+			__input_filenames.push_back(arg);
+			++num_inputs;
+		}
+	}
+
+	if (__options.link && (__options.batch || __options.object
+		|| !__options.cache_dir.empty()))
+	{
+		usage();
+	}
+
+	// The cache only knows about whole images, not relocations
+	if (__options.incremental && (__options.single_pass
+		|| __options.object || __options.link))
+	{
+		usage();
+	}
+
+	if ((__options.batch || __options.link) ? __input_filenames.empty()
+		: (num_inputs != 1))
+	{
+		usage();
+	}
+
+	// Batch mode's files are assembled at the same time, so no two of
+	// them can be written to the same output file, and no output file can
+	// be another one's input file
+	if (__options.batch)
+	{
+		std::map<std::string, std::string> input_of_output;
+
+		for (const auto& filename : __input_filenames)
+		{
+			const auto [iter, inserted] = input_of_output.emplace
+				(batch_output_filename(filename, __options), filename);
+
+			if (!inserted)
+			{
+				printerr("Error:  \"", iter->second, "\" and \"",
+					filename, "\" would both be written to \"",
+					iter->first, "\"\n");
+				exit(1);
+			}
+		}
+
+		for (const auto& filename : __input_filenames)
+		{
+			const auto iter = input_of_output.find(filename);
+
+			if (iter != input_of_output.end())
+			{
+				printerr("Error:  \"", iter->second, "\" would be ",
+					"written to input file \"", filename, "\"\n");
+				exit(1);
+			}
+		}
+	}
+
+	return ret;
+}
+
+void Assembler::write_object(FILE* some_outfile)
+{
+	ObjectFile object;
+	object.segments = __output_buf.segments();
+
+	for (const SymId sym_id : __global_syms)
+	{
+		const Symbol* sym = user_sym_tbl().find(sym_id);
+
+		object.syms.push_back(ObjectFile::Sym(sym_str(sym_id),
+			(sym->relocatable() ? ObjectFile::SymKind::Section
+			: ObjectFile::SymKind::Absolute), sym->value()));
+	}
+
+	// Each undefined symbol that's used gets imported once
+	std::map<SymId, size_t> import_indices;
+
+	for (const auto& iter : __output_buf.relocs())
+	{
+		Relocation reloc = iter.second;
+
+		if (reloc.target == RelocTarget::Symbol)
+		{
+			if (import_indices.count(reloc.sym) == 0)
+			{
+				import_indices[reloc.sym] = object.syms.size();
+				object.syms.push_back(ObjectFile::Sym(sym_str(reloc.sym),
+					ObjectFile::SymKind::Import, 0));
+			}
+
+			reloc.sym = import_indices.at(reloc.sym);
+		}
+		else
+		{
+			reloc.sym = 0;
+		}
+
+		object.relocs.push_back(reloc);
+	}
+
+	object.write(some_outfile);
+	__output_buf.clear();
+}
+
+void Assembler::check_global_syms()
+{
+	for (const SymId sym_id : __global_syms)
+	{
+		const Symbol* sym = user_sym_tbl().find(sym_id);
+
+		if ((sym == nullptr) || ((sym->type() != SymType::Other)
+			&& (sym->type() != SymType::EquateName)))
+		{
+			we().fail("Error:  \"", sym_str(sym_id), "\" is .global, but ",
+				"isn't a label or equate\n");
+		}
+	}
+}
+
+void Assembler::reinit()
+{
+	rewind(infile());
+	set_addr(0);
+	set_line_num(0);
+	set_next_char(' ');
+	__prev_tok = nullptr;
+	set_next_tok(nullptr);
+	set_next_sym_id(IdentPool::bad_id);
+	set_next_num(-1);
+	__output_buf.clear();
+}
+
+void Assembler::single_pass()
+{
+	set_pass(first_output_pass);
+	reinit();
+
+	__defined_syms.clear();
+
+	std::vector<Fixup> fixups;
+
+	lex_lines([&](size_t i) -> void
+	{
+		const auto& lexed_line = __lexed_lines[i];
+		const size_t line_addr = addr();
+
+		set_line_num(lexed_line.line_num);
+		set_found_forward_ref(false);
+		line(parse_span(lexed_line));
+
+		if (found_forward_ref())
+		{
+			fixups.push_back(Fixup(i, line_addr,
+				__output_buf.segments().size() - 1));
+		}
+	});
+
+	// Every label has its final value by now, so assemble the lines that
+	// needed one again, right over their old bytes.  Labels that never
+	// got defined are 0, same as in multi-pass mode.
+	__defined_syms.assign(__lexer.ident_pool().size(), true);
+
+	for (const auto& fixup : fixups)
+	{
+		const auto& lexed_line = __lexed_lines[fixup.lexed_line_index];
+
+		set_addr(fixup.addr);
+		set_line_num(lexed_line.line_num);
+		set_found_forward_ref(false);
+
+		__output_buf.begin_patch(fixup.segment_index);
+		line(parse_span(lexed_line));
+		__output_buf.end_patch();
+	}
+}
+
+void Assembler::set_sym_defined(SymId some_sym_id)
+{
+	if (some_sym_id >= __defined_syms.size())
+	{
+		__defined_syms.resize(some_sym_id + 1, false);
+	}
+	else if (__defined_syms[some_sym_id])
+	{
+		__found_redefinition = true;
+	}
+	__defined_syms[some_sym_id] = true;
+}
+
+Symbol& Assembler::define_sym(SymId some_sym_id, SymType some_type)
+{
+	if (Symbol* sym = user_sym_tbl().find(some_sym_id))
+	{
+		return *sym;
+	}
+
+	user_sym_tbl().insert_or_assign(Symbol(some_sym_id, &Tok::Ident, 0,
+		some_type));
+	return user_sym_tbl().at(some_sym_id);
+}
+
+void Assembler::update_changed()
+{
+	// Only the values that symbols have at the end of a pass are seen by
+	// the next one, so those are all that need comparing.  (An equate
+	// that gets redefined partway through still has the same value at
+	// the same point of every pass.)
+	set_changed(false);
+
+	const auto& symbols = user_sym_tbl().symbols();
+
+	if (__prev_sym_values.size() != symbols.size())
+	{
+		__prev_sym_values.resize(symbols.size(), 0);
+		set_changed(true);
+	}
+
+	for (size_t i=0; i<symbols.size(); ++i)
+	{
+		if (__prev_sym_values[i] != symbols[i].value())
+		{
+			__prev_sym_values[i] = symbols[i].value();
+			set_changed(true);
+		}
+	}
+}
+
+void Assembler::print_parse_vec
+	(ParseSpan some_parse_vec) const
+{
+	for (const auto& parse_iter : some_parse_vec)
+	{
+		printout(parse_iter.next_tok() != nullptr 
+			? parse_iter.next_tok()->str() : "nullptr", " ");
+	}
+	printout("\n");
+}
+
+void Assembler::next_line(size_t& some_outer_index, 
+	size_t& some_inner_index, std::vector<ParseNode>& some_parse_vec)
+{
+	//printout("next_line():  ", line_num(), ":  ",
+	//	next_tok() == nullptr ? "nullptr" : next_tok()->str(), "\n");
+
+	if (next_tok() == &Tok::Newline)
+	{
+		lex(some_outer_index, some_inner_index, true);
+	}
+
+	//printout("next_line():  ", line_num(), ":  ",
+	//	next_tok() == nullptr ? "nullptr" : next_tok()->str(), "\n");
+
+	bool found_comment = false;
+
+	while ((next_tok() != &Tok::Newline) && (next_tok() != &Tok::Eof)
+		&& (next_tok() != &Tok::Bad))
+	{
+		if (tok_is_comment(next_tok()))
+		{
+			found_comment = true;
+		}
+
+		if (!found_comment && (next_tok() != nullptr))
+		{
+			some_parse_vec.push_back(ParseNode(next_tok(), 
+				next_sym_id(), next_num()));
+		}
+		lex(some_outer_index, some_inner_index, true);
+	}
+
+}
+
+
+void Assembler::line(ParseSpan parse_vec)
+{
+	//printout("line():  ");
+	//print_parse_vec(parse_vec);
+
+	if ((parse_vec.size() == 0)
+		|| tok_is_comment(parse_vec.front()))
+	{
+		//printout("possible comment?");
+		return;
+	}
+
+	//for (const auto& node : parse_vec)
+	//{
+	//	printout(node.next_tok->str(), "\t\t");
+	//}
+	//printout("\n");
+
+	size_t index = 1;
+
+	// Ignore comments
+	size_t comment_index = 0;
+
+	while ((comment_index < parse_vec.size()) 
+		&& !tok_is_comment(parse_vec[comment_index]))
+	{
+		++comment_index;
+	}
+
+	if (handle_later_directives(index, parse_vec.subspan(0, comment_index)))
+	{
+		return;
+	}
+
+
+	const bool found_label = handle_label(parse_vec);
+
+	// Everything after the label, if there is one
+	const size_t first_index = found_label ? 2 : 0;
+	const ParseSpan second_parse_vec = parse_vec.subspan(first_index,
+		comment_index - first_index);
+
+	//printout("before finish_line():  ");
+	//print_parse_vec(parse_vec);
+	//print_parse_vec(second_parse_vec);
+	//printout("\n");
+
+	finish_line(second_parse_vec);
+}
+
+bool Assembler::handle_label(ParseSpan parse_vec)
+{
+	if (!line_has_label(parse_vec))
+	{
+		return false;
+	}
+
+	Symbol& sym = define_sym(parse_vec.at(0).next_sym_id, SymType::Other);
+
+	if (sym.type() == SymType::EquateName)
+	{
+		err("Can't use an equate as a label!");
+	}
+	else if (sym.type() != SymType::Other)
+	{
+		err("Invalid label name!");
+	}
+
+	// Update the value of the label in the user symbol table.  This
+	// happens regardless of what pass we're on.
+	sym.set_value(addr());
+	sym.set_relocatable(true);
+	set_sym_defined(parse_vec.at(0).next_sym_id);
+
+	return true;
+}
+
+bool Assembler::line_has_label(ParseSpan parse_vec) const
+{
+	return ((parse_vec.size() >= 2)
+		&& tok_is_ident_ish(parse_vec.at(0))
+		&& (parse_vec.at(1).next_tok_kind == TokKind::Colon));
+}
+
+void Assembler::finish_line
+	(ParseSpan some_parse_vec)
+{
+	//for (const auto& node : some_parse_vec)
+	//{
+	//	printout(node.next_tok->str(), "\t\t");
+	//}
+	//printout("\n");
+
+	if (some_parse_vec.size() == 0)
+	{
+		return;
+	}
+
+	
+	//{
+	//size_t index = 0;
+	//const auto temp = __handle_expr(some_parse_vec, index);
+
+	//printout(temp, "\n");
+
+	//set_addr(addr() + 4);
+	//}
+
+	//printout("finish_line():  ");
+	//print_parse_vec(some_parse_vec);
+
+
+	if (some_parse_vec.at(0).next_tok_kind != TokKind::Instr)
+	{
+		expected_tokens(&Tok::Instr);
+	}
+
+	const PInstr instr = find_instr(some_parse_vec);
+
+	if (instr == nullptr)
+	{
+		err("Invalid instruction arguments");
+	}
+
+	// Before output starts, all that matters is where the labels end up,
+	// so there's no need to evaluate or encode the operands.
+	if (pass() < first_output_pass)
+	{
+		__codegen.skip_instr(instr);
+		return;
+	}
+
+	const size_t instr_addr = addr();
+	__expr_reloc = ExprReloc();
+
+	if (!parse_instr(instr, some_parse_vec))
+	{
+		err("Invalid instruction arguments");
+	}
+
+	if (__options.object)
+	{
+		__reloc_instr(instr, instr_addr);
+	}
+}
+
+void Assembler::__reloc_instr(PInstr some_instr, size_t some_instr_addr)
+{
+	// Every field that can be relocated comes right after the high
+	// halfword
+	const size_t field_addr = some_instr_addr + 2;
+	RelocType type;
+
+	switch (some_instr->args())
+	{
+		case InstrArgs::UImm16:
+		case InstrArgs::SImm16:
+		case InstrArgs::RaUImm16:
+		case InstrArgs::RaRbUImm16:
+		case InstrArgs::RaRbSImm16:
+			type = RelocType::Imm16;
+			break;
+
+		case InstrArgs::Imm32:
+		case InstrArgs::LdStRaRbImm32:
+		case InstrArgs::RaRbImm32:
+			type = RelocType::Imm32;
+			break;
+
+		case InstrArgs::Branch:
+			// A branch to somewhere in the same section doesn't change
+			// when the section moves, but a branch to anywhere else does
+			if (__expr_reloc.target == RelocTarget::Section)
+			{
+				__output_buf.remove_reloc(field_addr);
+			}
+			else
+			{
+				__output_buf.set_reloc(Relocation(RelocType::Branch16,
+					__expr_reloc.target, field_addr, __expr_reloc.sym_id,
+					__expr_reloc.addend));
+			}
+			return;
+
+		default:
+			if ((__expr_reloc.target != RelocTarget::Absolute)
+				&& can_check_relocs())
+			{
+				err("This instruction can't use a relocatable value");
+			}
+			return;
+	}
+
+	if (__expr_reloc.target == RelocTarget::Absolute)
+	{
+		__output_buf.remove_reloc(field_addr);
+	}
+	else
+	{
+		__output_buf.set_reloc(Relocation(type, __expr_reloc.target,
+			field_addr, __expr_reloc.sym_id, __expr_reloc.addend));
+	}
+}
+
+void Assembler::append_operand_signature(std::string& ret,
+	ParseSpan some_parse_vec) const
+{
+	for (size_t i=1; i<some_parse_vec.size(); ++i)
+	{
+		const TokKind kind = some_parse_vec[i].next_tok_kind;
+		char c;
+
+		if (kind == TokKind::Reg)
+		{
+			c = 'r';
+		}
+		else if (kind == TokKind::RegIra)
+		{
+			c = 'i';
+		}
+		else if (kind == TokKind::RegFlags)
+		{
+			c = 'f';
+		}
+		else if (kind == TokKind::RegPc)
+		{
+			c = 'p';
+		}
+		else if ((kind == TokKind::Comma) || (kind == TokKind::Colon)
+			|| (kind == TokKind::LBracket) || (kind == TokKind::RBracket)
+			|| (kind == TokKind::LBrace) || (kind == TokKind::RBrace))
+		{
+			c = Tok::from_kind(kind)->str().front();
+		}
+		else
 		{
-			builtin_sym_tbl().insert_or_assign(Symbol(instr->str(), 
-				&Tok::Instr, -1));
+			// Part of an expression
+			if ((ret.size() != 0) && (ret.back() == 'e'))
+			{
+				continue;
+			}
+			c = 'e';
 		}
-	}
-}
 
-void Assembler::print_parse_vec
-	(const std::vector<ParseNode> some_parse_vec) const
-{
-	for (const auto& parse_iter : some_parse_vec)
-	{
-		printout(parse_iter.next_tok != nullptr 
-			? parse_iter.next_tok->str() : "nullptr", " ");
+		ret += c;
 	}
-	printout("\n");
 }
 
-void Assembler::next_line(size_t& some_outer_index, 
-	size_t& some_inner_index, std::vector<ParseNode>& some_parse_vec)
+PInstr Assembler::find_instr(ParseSpan some_parse_vec)
 {
-	//printout("next_line():  ", line_num(), ":  ",
-	//	next_tok() == nullptr ? "nullptr" : next_tok()->str(), "\n");
+	const SymId mnemonic_id = some_parse_vec.at(0).next_sym_id;
 
-	if (next_tok() == &Tok::Newline)
+	if (mnemonic_id >= __instr_by_signature.size())
 	{
-		lex(some_outer_index, some_inner_index, true);
+		__instr_by_signature.resize(mnemonic_id + 1);
 	}
 
-	//printout("next_line():  ", line_num(), ":  ",
-	//	next_tok() == nullptr ? "nullptr" : next_tok()->str(), "\n");
+	auto& by_signature = __instr_by_signature[mnemonic_id];
 
-	bool found_comment = false;
+	std::string signature;
+	append_operand_signature(signature, some_parse_vec);
 
-	while ((next_tok() != &Tok::Newline) && (next_tok() != &Tok::Eof))
+	auto iter = by_signature.find(signature);
+
+	if (iter != by_signature.end())
 	{
-		if (tok_is_comment(next_tok()))
-		{
-			found_comment = true;
-		}
+		return iter->second;
+	}
 
-		if (!found_comment && (next_tok() != nullptr))
+	// First time we've seen this signature for this mnemonic, so find the
+	// first overload that it fits, same order as the overloads were
+	// always tried in.
+	PInstr ret = nullptr;
+
+	for (const auto& instr : *builtin_syms::at(mnemonic_id))
+	{
+		if (InstructionTable::args_match_signature(instr->args(), 
+			signature))
 		{
-			some_parse_vec.push_back(ParseNode(next_tok(), 
-				next_sym_str(), next_num()));
+			ret = instr;
+			break;
 		}
-		lex(some_outer_index, some_inner_index, true);
 	}
 
-}
+	by_signature.emplace(std::move(signature), ret);
 
+	return ret;
+}
 
-void Assembler::line(size_t& some_outer_index, size_t& some_inner_index)
+void Assembler::read_input(std::string& ret)
 {
-	std::vector<ParseNode> parse_vec, second_parse_vec;
+	ret.clear();
+
+	// Only a file that can be seeked in has a size to reserve.  Anything
+	// else is read from wherever it's at.
+	const long start = ftell(infile());
 
-	auto call_lex = [&]() -> void
+	if ((start >= 0) && (fseek(infile(), 0, SEEK_END) == 0))
 	{
-		lex(some_outer_index, some_inner_index, true);
-	};
+		const long file_size = ftell(infile());
+
+		if (file_size > start)
+		{
+			ret.reserve(file_size - start);
+		}
+
+		fseek(infile(), start, SEEK_SET);
+	}
 
+	read_whole_file(infile(), ret);
+}
 
-	next_line(some_outer_index, some_inner_index, parse_vec);
+void Assembler::fill_lines(std::string&& some_input)
+{
+	reinit();
 
+	__input = std::move(some_input);
+	__lines.clear();
 
-	//printout("line():  ");
-	//print_parse_vec(parse_vec);
+	// The lines are just views into __input.
+	size_t line_start = 0;
 
-	if (next_tok() == &Tok::Bad)
+	while (line_start < __input.size())
 	{
-		set_line_num(line_num() + 1);
-		err("Invalid syntax");
+		size_t line_end = __input.find('\n', line_start);
+
+		if (line_end == std::string::npos)
+		{
+			line_end = __input.size();
+		}
+		else
+		{
+			++line_end;
+		}
+
+		__lines.push_back(std::string_view(__input.data() + line_start,
+			line_end - line_start));
+		line_start = line_end;
 	}
+}
 
-	if ((parse_vec.size() == 0)
-		|| tok_is_comment(parse_vec.front().next_tok))
+void Assembler::lex_lines(const std::function<void(size_t)>& some_on_line)
+{
+	__lexed_lines.clear();
+	__parse_nodes.clear();
+
+	// With one thread, each line goes through the first pass as soon as
+	// it's lexed, so any error in an earlier line gets reported before a
+	// lexer error stops everything.  The first pass sets the line number,
+	// so the lexer's own has to be put back afterwards.
+	if (num_threads() <= 1)
 	{
-		//lex(!just_find_defines);
-
-		//printout("possible comment?");
-		call_lex();
+		__lex_batches(1, [&](LexedBatch&& some_batch) -> void
+		{
+			const size_t lexer_line_num = line_num();
+			__take_batch(std::move(some_batch), some_on_line);
+			set_line_num(lexer_line_num);
+		});
 		return;
 	}
 
-	//for (const auto& node : parse_vec)
-	//{
-	//	printout(node.next_tok->str(), "\t\t");
-	//}
-	//printout("\n");
+	// Otherwise, the lexing is done by another Assembler, which has its
+	// own lexer state and line number.
+	std::atomic<bool> stop_lexing = false;
+	Assembler lexer_asm;
+	lexer_asm.__init_lexer(*this, &stop_lexing);
 
-	size_t index = 1;
+	BoundedQueue<LexedBatch, max_batches_queued> queue;
 
+	std::thread lexer_thread([&]() -> void
 	{
+		lexer_asm.__lex_batches(lines_per_batch,
+			[&](LexedBatch&& some_batch) -> void
+		{
+			queue.push(std::move(some_batch));
+		});
+	});
 
-	std::vector<ParseNode> later_directives_parse_vec;
+	// Nothing comes after the last batch or an error
+	bool lexer_done = false;
 
-	for (const auto& parse_iter : parse_vec)
+	// The lexer thread reads __lines, so it has to be finished with before
+	// an error can exit(), or anything else thrown can leave this
+	// function.  That's why errors are deferred until then.
+	auto stop_lexer = [&]() -> void
 	{
-		if (tok_is_comment(parse_iter.next_tok))
+		stop_lexing = true;
+
+		while (!lexer_done)
 		{
-			break;
+			const LexedBatch batch = queue.pop();
+			lexer_done = (batch.last || batch.error);
 		}
-		later_directives_parse_vec.push_back(parse_iter);
-	}
-
-	if (handle_later_directives(some_outer_index, some_inner_index, index,
-		later_directives_parse_vec))
-	{
-		return;
-	}
-	}
 
+		lexer_thread.join();
+	};
 
-	bool found_label = false;
+	const bool was_deferred = we().set_defer(true);
 
-	// Check for a label
-	if (parse_vec.size() >= 2)
+	try
 	{
-		if (tok_is_ident_ish(parse_vec.at(0).next_tok) 
-			&& parse_vec.at(1).next_tok == &Tok::Colon)
+		while (!lexer_done)
 		{
-			found_label = true;
+			LexedBatch batch = queue.pop();
+			lexer_done = (batch.last || batch.error);
 
-			if (user_sym_tbl().at(parse_vec.at(0).next_sym_str).type()
-				== SymType::EquateName)
-			{
-				err("Can't use an equate as a label!");
-			}
-			else if (user_sym_tbl().at(parse_vec.at(0).next_sym_str)
-				.type() != SymType::Other)
+			if (lexer_done)
 			{
-				err("Invalid label name!");
+				lexer_thread.join();
 			}
 
-			// Update the value of the label in the user symbol table.
-			// This happens regardless of what pass we're on.
-			user_sym_tbl().at(parse_vec.at(0).next_sym_str).set_value
-				(addr());
+			__take_batch(std::move(batch), some_on_line);
 		}
 	}
-
-	if (!found_label)
+	catch (const WarnError::Deferred&)
 	{
-		for (size_t i=0; i<parse_vec.size(); ++i)
+		if (lexer_thread.joinable())
 		{
-			// Ignore comments
-			if (tok_is_comment(parse_vec.at(i).next_tok))
-			{
-				break;
-			}
-			second_parse_vec.push_back(parse_vec.at(i));
+			stop_lexer();
+		}
+
+		we().set_defer(was_deferred);
+
+		if (was_deferred)
+		{
+			throw;
 		}
+
+		we().fail(we().deferred_msg());
 	}
-	else
+	catch (...)
 	{
-		for (size_t i=2; i<parse_vec.size(); ++i)
+		if (lexer_thread.joinable())
 		{
-			// Ignore comments
-			if (tok_is_comment(parse_vec.at(i).next_tok))
-			{
-				break;
-			}
-			second_parse_vec.push_back(parse_vec.at(i));
+			stop_lexer();
 		}
+
+		we().set_defer(was_deferred);
+		throw;
 	}
 
-	//printout("before finish_line():  ");
-	//print_parse_vec(parse_vec);
-	//print_parse_vec(second_parse_vec);
-	//printout("\n");
+	we().set_defer(was_deferred);
 
-	finish_line(second_parse_vec);
-	//lex(!just_find_defines);
-	call_lex();
+	__lexer.ident_pool() = std::move(lexer_asm.__lexer.ident_pool());
 }
 
-void Assembler::finish_line
-	(const std::vector<ParseNode>& some_parse_vec)
+void Assembler::__init_lexer(const Assembler& some_main,
+	const std::atomic<bool>* some_stop)
 {
-	//for (const auto& node : some_parse_vec)
-	//{
-	//	printout(node.next_tok->str(), "\t\t");
-	//}
-	//printout("\n");
+	__we.defer();
+	__lexing_for = &some_main;
+	__stop_lexing = some_stop;
+}
 
-	if (some_parse_vec.size() == 0)
+void Assembler::__lex_batches(size_t some_lines_per_batch,
+	const std::function<void(LexedBatch&&)>& some_on_batch)
+{
+	LexedBatch batch;
+
+	try
 	{
-		return;
-	}
+		size_t outer_index = 0, inner_index = 0;
 
-	
-	//{
-	//size_t index = 0;
-	//const auto temp = __handle_expr(some_parse_vec, index);
+		lex(outer_index, inner_index, true);
 
-	//printout(temp, "\n");
+		while ((next_tok() != &Tok::Eof)
+			&& ((__stop_lexing == nullptr) || !__stop_lexing->load
+			(std::memory_order_relaxed)))
+		{
+			const size_t first_node = batch.parse_nodes.size();
+			next_line(outer_index, inner_index, batch.parse_nodes);
+			const ParseSpan parse_vec(batch.parse_nodes.data() 
+				+ first_node, batch.parse_nodes.size() - first_node);
 
-	//set_addr(addr() + 4);
-	//}
+			if (next_tok() == &Tok::Bad)
+			{
+				set_line_num(line_num() + 1);
+				err("Invalid syntax");
+			}
 
-	//printout("finish_line():  ");
-	//print_parse_vec(some_parse_vec);
+			add_define_names(parse_vec, batch);
 
+			// Blank lines and comments don't need to be seen by the
+			// passes.
+			if (parse_vec.size() != 0)
+			{
+				batch.lexed_lines.push_back(LexedLine(line_num(),
+					first_node, parse_vec.size()));
+			}
 
-	if (some_parse_vec.at(0).next_tok != &Tok::Instr)
-	{
-		expected_tokens(&Tok::Instr);
+			if (batch.lexed_lines.size() >= some_lines_per_batch)
+			{
+				some_on_batch(std::move(batch));
+				batch.clear();
+			}
+
+			// Skip the newline
+			lex(outer_index, inner_index, true);
+		}
+
+		batch.last = true;
 	}
+	catch (const WarnError::Deferred&)
+	{
+		// Lexing for itself, the error message is already where it
+		// belongs
+		if (__lexing_for == nullptr)
+		{
+			throw;
+		}
 
-	const auto& instr_vec = __instr_tbl.at(some_parse_vec.at(0)
-		.next_sym_str);
+		batch.error = true;
+		batch.error_msg = we().deferred_msg();
+	}
 
+	some_on_batch(std::move(batch));
+}
 
+void Assembler::__take_batch(LexedBatch&& some_batch,
+	const std::function<void(size_t)>& some_on_line)
+{
+	const size_t first_node = __parse_nodes.size();
+	const size_t first_line = __lexed_lines.size();
+	size_t define_index = 0;
 
-	bool complete = false;
+	__parse_nodes.insert(__parse_nodes.end(), 
+		some_batch.parse_nodes.begin(), some_batch.parse_nodes.end());
 
-	for (const auto& instr : instr_vec)
+	for (size_t i=0; i<some_batch.lexed_lines.size(); ++i)
 	{
-		if (parse_instr(instr, some_parse_vec))
+		LexedLine lexed_line = some_batch.lexed_lines[i];
+		lexed_line.first_node += first_node;
+		__lexed_lines.push_back(lexed_line);
+
+		while ((define_index < some_batch.define_names.size())
+			&& (some_batch.define_names[define_index].first == i))
 		{
-			complete = true;
-			break;
+			define_sym(some_batch.define_names[define_index].second,
+				SymType::DefineName);
+			++define_index;
 		}
+
+		some_on_line(first_line + i);
 	}
 
-	if (!complete)
+	// Errors are reported in the order they're found in the file, so a
+	// lexer error only gets reported once every line before it has been
+	// through the first pass
+	if (some_batch.error)
 	{
-		err("Invalid instruction arguments");
+		we().fail(some_batch.error_msg);
 	}
-
 }
 
-void Assembler::fill_lines()
+void Assembler::add_define_names(ParseSpan some_parse_vec,
+	LexedBatch& some_batch)
 {
-	reinit();
-
+	for (size_t i=0; i<some_parse_vec.size(); ++i)
 	{
-	std::string some_line;
+		const SymId some_sym_id = some_parse_vec.at(i).next_sym_id;
 
-	size_t outer_index = 0, inner_index = 0;
-
-	//while (next_tok() != &Tok::Eof)
-	while (next_char() != EOF)
-	{
-		advance(outer_index, inner_index);
-
-		if ((next_char() != '\n') && (next_char() != EOF))
+		// Defines must start with "`"
+		if ((some_parse_vec.at(i).next_tok_kind != TokKind::Ident)
+			|| (sym_str(some_sym_id).front() != '`')
+			|| user_sym_tbl().contains(some_sym_id))
 		{
-			some_line += next_char();
+			continue;
 		}
-		else // if ((next_char() == '\n') || (next_char() == EOF))
-		{
-			if (next_char() == '\n')
-			{
-				some_line += '\n';
-			}
 
-			// Don't append a blank line
-			if (some_line.size() >= 1)
-			{
-				__lines.push_back(some_line);
-				some_line = "";
-			}
+		if ((i == 1) && (some_parse_vec.front().next_tok_kind 
+			!= TokKind::DotDef))
+		{
+			err("Undefined .def (perhaps just not YET defined?)");
 		}
-	}
+
+		define_sym(some_sym_id, SymType::DefineName);
+		some_batch.define_names.push_back(std::pair(some_batch
+			.lexed_lines.size(), some_sym_id));
 	}
 }
 
@@ -675,7 +2000,7 @@ bool Assembler::handle_earlier_directives(size_t& some_outer_index,
 			continue;
 		}
 
-		if (parse_vec.front().next_tok == &Tok::DotIf)
+		if (parse_vec.front().next_tok_kind == TokKind::DotIf)
 		{
 			const size_t first_line_num = line_num();
 
@@ -716,10 +2041,10 @@ bool Assembler::find_matching_directive(size_t& some_outer_index,
 			"(ret_lines_vec.back().size() == 0)!");
 	}
 
-	if (ret_lines_vec.back().front().next_tok != start)
+	if (ret_lines_vec.back().front().next_tok_kind != start->kind())
 	{
 		err("find_matching_directive():  Bug in assembler ",
-			"(ret_lines_vec.back().front().next_tok != ", start->str(), 
+			"(ret_lines_vec.back().front().next_tok() != ", start->str(), 
 			")!");
 	}
 
@@ -743,12 +2068,12 @@ bool Assembler::find_matching_directive(size_t& some_outer_index,
 			continue;
 		}
 
-		if (ret_lines_vec.back().front().next_tok == start)
+		if (ret_lines_vec.back().front().next_tok_kind == start->kind())
 		{
 			++num_start_toks;
 		}
 
-		else if (ret_lines_vec.back().front().next_tok == end)
+		else if (ret_lines_vec.back().front().next_tok_kind == end->kind())
 		{
 			++num_end_toks;
 		}
@@ -847,7 +2172,7 @@ void Assembler::handle_dot_if(size_t& some_outer_index,
 
 }
 
-bool Assembler::handle_condition(const std::vector<ParseNode>& line_iter,
+bool Assembler::handle_condition(ParseSpan line_iter,
 	size_t start_index, const size_t end_index_exclusive)
 {
 	// Temporary
@@ -855,13 +2180,12 @@ bool Assembler::handle_condition(const std::vector<ParseNode>& line_iter,
 }
 
 
-bool Assembler::handle_later_directives(size_t& some_outer_index, 
-	size_t& some_inner_index, size_t& index,
-	const std::vector<ParseNode>& parse_vec)
+bool Assembler::handle_later_directives(size_t& index,
+	ParseSpan parse_vec)
 {
 	auto eek = [&]() -> void
 	{
-		err("invalid syntax for ", parse_vec.front().next_tok->str());
+		err("invalid syntax for ", parse_vec.front().next_tok()->str());
 	};
 
 	//printout("handle_later_directives():  ");
@@ -869,12 +2193,26 @@ bool Assembler::handle_later_directives(size_t& some_outer_index,
 
 
 	// Check for assembler directives
-	if (parse_vec.front().next_tok == &Tok::DotOrg)
+	if (parse_vec.front().next_tok_kind == TokKind::DotOrg)
 	{
 		if (pass() > 0)
 		{
 			// .org expr
 			set_addr(better_expr(parse_vec, index));
+
+			if (found_forward_ref())
+			{
+				err(".org can't use labels defined later on in ",
+					"single-pass mode");
+			}
+
+			// In an object file, .org sets the address within the
+			// section
+			if ((__expr_reloc.target == RelocTarget::Symbol)
+				&& can_check_relocs())
+			{
+				err(".org can't use symbols from other object files");
+			}
 			//printout("addr(), last_addr():  ", addr(), ", ", last_addr(),
 			//	"\n");
 
@@ -886,7 +2224,7 @@ bool Assembler::handle_later_directives(size_t& some_outer_index,
 
 		return true;
 	}
-	else if (parse_vec.front().next_tok == &Tok::DotB)
+	else if (parse_vec.front().next_tok_kind == TokKind::DotB)
 	{
 		if (pass() > 0)
 		{
@@ -896,9 +2234,12 @@ bool Assembler::handle_later_directives(size_t& some_outer_index,
 			for (;;)
 			{
 				__codegen.gen8(better_expr(parse_vec, index));
-				if (pass() == last_pass)
+				__codegen.end_item();
+
+				if ((__expr_reloc.target != RelocTarget::Absolute)
+					&& can_check_relocs())
 				{
-					printout("\n");
+					err(".db can't use a relocatable value");
 				}
 
 				if (index >= parse_vec.size())
@@ -906,7 +2247,7 @@ bool Assembler::handle_later_directives(size_t& some_outer_index,
 					break;
 				}
 				
-				if (parse_vec.at(index).next_tok != &Tok::Comma)
+				if (parse_vec.at(index).next_tok_kind != TokKind::Comma)
 				{
 					eek();
 				}
@@ -917,7 +2258,7 @@ bool Assembler::handle_later_directives(size_t& some_outer_index,
 
 		return true;
 	}
-	else if (parse_vec.front().next_tok == &Tok::DotW)
+	else if (parse_vec.front().next_tok_kind == TokKind::DotW)
 	{
 		if (pass() > 0)
 		{
@@ -926,10 +2267,24 @@ bool Assembler::handle_later_directives(size_t& some_outer_index,
 			// .dw expr, expr2, ...
 			for (;;)
 			{
-				__codegen.gen32(__handle_expr(parse_vec, index));
-				if (pass() == last_pass)
+				const size_t word_addr = addr();
+				const s64 expr_result = __handle_expr(parse_vec, index);
+
+				__codegen.gen32(expr_result);
+				__codegen.end_item();
+
+				if (__options.object && (pass() >= first_output_pass))
 				{
-					printout("\n");
+					if (__expr_reloc.target == RelocTarget::Absolute)
+					{
+						__output_buf.remove_reloc(word_addr);
+					}
+					else
+					{
+						__output_buf.set_reloc(Relocation
+							(RelocType::Imm32, __expr_reloc.target,
+							word_addr, __expr_reloc.sym_id, expr_result));
+					}
 				}
 
 				if (index >= parse_vec.size())
@@ -937,7 +2292,7 @@ bool Assembler::handle_later_directives(size_t& some_outer_index,
 					break;
 				}
 				
-				if (parse_vec.at(index).next_tok != &Tok::Comma)
+				if (parse_vec.at(index).next_tok_kind != TokKind::Comma)
 				{
 					eek();
 				}
@@ -951,7 +2306,7 @@ bool Assembler::handle_later_directives(size_t& some_outer_index,
 
 
 	#define TOKEN_STUFF(varname, value) \
-		(parse_vec.front().next_tok == &Tok::varname) ||
+		(parse_vec.front().next_tok_kind == TokKind::varname) ||
 	else if (LIST_OF_EQUATE_DIRECTIVE_TOKENS(TOKEN_STUFF) false)
 	{
 	#undef TOKEN_STUFF
@@ -961,7 +2316,7 @@ bool Assembler::handle_later_directives(size_t& some_outer_index,
 			eek();
 		}
 
-		if (!tok_is_ident_ish(parse_vec.at(1).next_tok))
+		if (!tok_is_ident_ish(parse_vec.at(1)))
 		{
 			eek();
 		}
@@ -970,8 +2325,10 @@ bool Assembler::handle_later_directives(size_t& some_outer_index,
 		//	(int)user_sym_tbl().at(parse_vec.at(1).next_sym_str).type(), 
 		//	"\n");
 
-		if (user_sym_tbl().at(parse_vec.at(1).next_sym_str).type() 
-			!= SymType::EquateName)
+		Symbol& sym = define_sym(parse_vec.at(1).next_sym_id,
+			SymType::EquateName);
+
+		if (sym.type() != SymType::EquateName)
 		{
 			err("Can't convert a label to an equate!");
 		}
@@ -980,13 +2337,58 @@ bool Assembler::handle_later_directives(size_t& some_outer_index,
 
 		s64 expr_result = __handle_expr(parse_vec, index);
 
-		user_sym_tbl().at(parse_vec.at(1).next_sym_str).set_value
-			(expr_result);
+		if (found_forward_ref())
+		{
+			err("Equates can't use labels defined later on in ",
+				"single-pass mode");
+		}
+
+		if ((__expr_reloc.target == RelocTarget::Symbol)
+			&& can_check_relocs())
+		{
+			err("Equates can't use symbols from other object files");
+		}
+
+		sym.set_value(expr_result);
+		sym.set_relocatable(__expr_reloc.target == RelocTarget::Section);
+		set_sym_defined(parse_vec.at(1).next_sym_id);
+
+		return true;
+	}
+
+	else if (parse_vec.front().next_tok_kind == TokKind::DotGlobal)
+	{
+		// .global ident
+		// .global ident, ident2
+		// .global ident, ident2, ...
+		for (;;)
+		{
+			if ((index >= parse_vec.size())
+				|| !tok_is_ident_ish(parse_vec.at(index)))
+			{
+				eek();
+			}
+
+			__global_syms.insert(parse_vec.at(index).next_sym_id);
+			++index;
+
+			if (index >= parse_vec.size())
+			{
+				break;
+			}
+
+			if (parse_vec.at(index).next_tok_kind != TokKind::Comma)
+			{
+				eek();
+			}
+
+			++index;
+		}
 
 		return true;
 	}
 
-	else if (parse_vec.front().next_tok == &Tok::DotDef)
+	else if (parse_vec.front().next_tok_kind == TokKind::DotDef)
 	{
 		
 		//if (!just_find_defines)
@@ -1145,10 +2547,12 @@ void Assembler::split(std::vector<ParseNode>& ret,
 	std::vector<std::string>& to_split,
 	std::vector<ParsePos>* pos_vec)
 {
+	const std::vector<std::string_view> to_split_views(to_split.begin(),
+		to_split.end());
 	size_t outer_index = 0, inner_index = 0;
 	int some_next_char = ' ';
 	PTok some_prev_tok = nullptr, some_next_tok = nullptr;
-	std::string some_next_sym_str;
+	SymId some_next_sym_id = IdentPool::bad_id;
 	s64 some_next_num = -1;
 	size_t some_line_num = 0;
 
@@ -1156,8 +2560,8 @@ void Assembler::split(std::vector<ParseNode>& ret,
 	{
 		ParsePos pos;
 		__lexer.__lex_innards(some_next_char, some_next_tok, some_prev_tok,
-			some_next_sym_str, some_next_num, some_line_num, outer_index,
-			inner_index, &to_split, &pos);
+			some_next_sym_id, some_next_num, some_line_num, outer_index,
+			inner_index, &to_split_views, &pos);
 
 		if (pos_vec != nullptr)
 		{
@@ -1169,7 +2573,7 @@ void Assembler::split(std::vector<ParseNode>& ret,
 			&& !tok_is_comment(some_next_tok))
 		{
 			ret.push_back(ParseNode(some_next_tok,
-				some_next_sym_str, some_next_num));
+				some_next_sym_id, some_next_num));
 		}
 
 		if (tok_is_comment(some_next_tok))
@@ -1182,7 +2586,7 @@ void Assembler::split(std::vector<ParseNode>& ret,
 
 
 bool Assembler::parse_instr(PInstr instr,
-	const std::vector<ParseNode>& some_parse_vec)
+	ParseSpan some_parse_vec)
 {
 	switch (instr->args())
 	{
@@ -1299,9 +2703,9 @@ bool Assembler::parse_instr(PInstr instr,
 #define spvat(x) some_parse_vec.at(x)
 
 bool Assembler::__parse_instr_no_args
-	(const std::vector<ParseNode>& some_parse_vec, PInstr instr)
+	(ParseSpan some_parse_vec, PInstr instr)
 {
-	std::vector<std::string> regs;
+	RegList regs;
 	//size_t index = 1;
 	s64 expr_result = 0;
 
@@ -1316,9 +2720,9 @@ bool Assembler::__parse_instr_no_args
 	return true;
 }
 bool Assembler::__parse_instr_uimm16
-	(const std::vector<ParseNode>& some_parse_vec, PInstr instr)
+	(ParseSpan some_parse_vec, PInstr instr)
 {
-	std::vector<std::string> regs;
+	RegList regs;
 	size_t index = 1;
 	s64 expr_result = 0;
 
@@ -1335,9 +2739,9 @@ bool Assembler::__parse_instr_uimm16
 	return true;
 }
 bool Assembler::__parse_instr_simm16
-	(const std::vector<ParseNode>& some_parse_vec, PInstr instr)
+	(ParseSpan some_parse_vec, PInstr instr)
 {
-	std::vector<std::string> regs;
+	RegList regs;
 	size_t index = 1;
 	s64 expr_result = 0;
 
@@ -1354,9 +2758,9 @@ bool Assembler::__parse_instr_simm16
 	return true;
 }
 bool Assembler::__parse_instr_imm32
-	(const std::vector<ParseNode>& some_parse_vec, PInstr instr)
+	(ParseSpan some_parse_vec, PInstr instr)
 {
-	std::vector<std::string> regs;
+	RegList regs;
 	size_t index = 1;
 	s64 expr_result = 0;
 
@@ -1374,9 +2778,9 @@ bool Assembler::__parse_instr_imm32
 }
 
 bool Assembler::__parse_instr_ra
-	(const std::vector<ParseNode>& some_parse_vec, PInstr instr)
+	(ParseSpan some_parse_vec, PInstr instr)
 {
-	std::vector<std::string> regs;
+	RegList regs;
 	//size_t index = 1;
 	s64 expr_result = 0;
 
@@ -1387,21 +2791,21 @@ bool Assembler::__parse_instr_ra
 		return false;
 	}
 
-	if (spvat(1).next_tok != &Tok::Reg)
+	if (spvat(1).next_tok_kind != TokKind::Reg)
 	{
 		return false;
 	}
 
-	regs.push_back(spvat(1).next_sym_str);
+	regs.push_back(spvat(1).next_num);
 
 	__codegen.encode_and_gen(regs, expr_result, instr);
 
 	return true;
 }
 bool Assembler::__parse_instr_ra_uimm16
-	(const std::vector<ParseNode>& some_parse_vec, PInstr instr)
+	(ParseSpan some_parse_vec, PInstr instr)
 {
-	std::vector<std::string> regs;
+	RegList regs;
 	size_t index = 1;
 	s64 expr_result = 0;
 
@@ -1412,24 +2816,24 @@ bool Assembler::__parse_instr_ra_uimm16
 	}
 
 
-	if ((spvat(index++).next_tok != &Tok::Reg)
-		|| (spvat(index++).next_tok != &Tok::Comma))
+	if ((spvat(index++).next_tok_kind != TokKind::Reg)
+		|| (spvat(index++).next_tok_kind != TokKind::Comma))
 	{
 		return false;
 	}
 
 	expr_result = better_expr(some_parse_vec, index);
 
-	regs.push_back(spvat(1).next_sym_str);
+	regs.push_back(spvat(1).next_num);
 
 	__codegen.encode_and_gen(regs, expr_result, instr);
 
 	return true;
 }
 bool Assembler::__parse_instr_ra_rb
-	(const std::vector<ParseNode>& some_parse_vec, PInstr instr)
+	(ParseSpan some_parse_vec, PInstr instr)
 {
-	std::vector<std::string> regs;
+	RegList regs;
 	size_t index = 1;
 	s64 expr_result = 0;
 
@@ -1446,8 +2850,8 @@ bool Assembler::__parse_instr_ra_rb
 	}
 
 
-	regs.push_back(spvat(1).next_sym_str);
-	regs.push_back(spvat(3).next_sym_str);
+	regs.push_back(spvat(1).next_num);
+	regs.push_back(spvat(3).next_num);
 
 	
 	__codegen.encode_and_gen(regs, expr_result, instr);
@@ -1455,9 +2859,9 @@ bool Assembler::__parse_instr_ra_rb
 	return true;
 }
 bool Assembler::__parse_instr_ra_rb_uimm16
-	(const std::vector<ParseNode>& some_parse_vec, PInstr instr)
+	(ParseSpan some_parse_vec, PInstr instr)
 {
-	std::vector<std::string> regs;
+	RegList regs;
 	size_t index = 1;
 	s64 expr_result = 0;
 
@@ -1474,8 +2878,8 @@ bool Assembler::__parse_instr_ra_rb_uimm16
 		return false;
 	}
 
-	regs.push_back(spvat(1).next_sym_str);
-	regs.push_back(spvat(3).next_sym_str);
+	regs.push_back(spvat(1).next_num);
+	regs.push_back(spvat(3).next_num);
 
 	expr_result = better_expr(some_parse_vec, index);
 
@@ -1484,9 +2888,9 @@ bool Assembler::__parse_instr_ra_rb_uimm16
 	return true;
 }
 bool Assembler::__parse_instr_ra_rb_simm16
-	(const std::vector<ParseNode>& some_parse_vec, PInstr instr)
+	(ParseSpan some_parse_vec, PInstr instr)
 {
-	std::vector<std::string> regs;
+	RegList regs;
 	size_t index = 1;
 	s64 expr_result = 0;
 
@@ -1502,8 +2906,8 @@ bool Assembler::__parse_instr_ra_rb_simm16
 		return false;
 	}
 
-	regs.push_back(spvat(1).next_sym_str);
-	regs.push_back(spvat(3).next_sym_str);
+	regs.push_back(spvat(1).next_num);
+	regs.push_back(spvat(3).next_num);
 
 	expr_result = better_expr(some_parse_vec, index);
 
@@ -1512,9 +2916,9 @@ bool Assembler::__parse_instr_ra_rb_simm16
 	return true;
 }
 bool Assembler::__parse_instr_ra_rb_rc
-	(const std::vector<ParseNode>& some_parse_vec, PInstr instr)
+	(ParseSpan some_parse_vec, PInstr instr)
 {
-	std::vector<std::string> regs;
+	RegList regs;
 	size_t index = 1;
 	s64 expr_result = 0;
 
@@ -1530,18 +2934,18 @@ bool Assembler::__parse_instr_ra_rb_rc
 		return false;
 	}
 
-	regs.push_back(spvat(1).next_sym_str);
-	regs.push_back(spvat(3).next_sym_str);
-	regs.push_back(spvat(5).next_sym_str);
+	regs.push_back(spvat(1).next_num);
+	regs.push_back(spvat(3).next_num);
+	regs.push_back(spvat(5).next_num);
 
 	__codegen.encode_and_gen(regs, expr_result, instr);
 
 	return true;
 }
 bool Assembler::__parse_instr_ra_rb_rc_simm12
-	(const std::vector<ParseNode>& some_parse_vec, PInstr instr)
+	(ParseSpan some_parse_vec, PInstr instr)
 {
-	std::vector<std::string> regs;
+	RegList regs;
 	size_t index = 1;
 	s64 expr_result = 0;
 
@@ -1557,9 +2961,9 @@ bool Assembler::__parse_instr_ra_rb_rc_simm12
 		return false;
 	}
 
-	regs.push_back(spvat(1).next_sym_str);
-	regs.push_back(spvat(3).next_sym_str);
-	regs.push_back(spvat(5).next_sym_str);
+	regs.push_back(spvat(1).next_num);
+	regs.push_back(spvat(3).next_num);
+	regs.push_back(spvat(5).next_num);
 
 
 	expr_result = better_expr(some_parse_vec, index);
@@ -1571,9 +2975,9 @@ bool Assembler::__parse_instr_ra_rb_rc_simm12
 }
 
 bool Assembler::__parse_instr_ldst_ra_rb
-	(const std::vector<ParseNode>& some_parse_vec, PInstr instr)
+	(ParseSpan some_parse_vec, PInstr instr)
 {
-	std::vector<std::string> regs;
+	RegList regs;
 	size_t index = 1;
 	s64 expr_result = 0;
 
@@ -1590,23 +2994,23 @@ bool Assembler::__parse_instr_ldst_ra_rb
 		return false;
 	}
 
-	regs.push_back(spvat(1).next_sym_str);
-	regs.push_back(spvat(4).next_sym_str);
+	regs.push_back(spvat(1).next_num);
+	regs.push_back(spvat(4).next_num);
 
 	__codegen.encode_and_gen(regs, expr_result, instr);
 
 	return true;
 }
 bool Assembler::__parse_instr_ldst_ra_rb_rc_simm12
-	(const std::vector<ParseNode>& some_parse_vec, PInstr instr)
+	(ParseSpan some_parse_vec, PInstr instr)
 {
-	std::vector<std::string> regs;
+	RegList regs;
 	size_t index = 1;
 	s64 expr_result = 0;
 
 	// op rA , [ rB , rC , expr ]
 	if ((some_parse_vec.size() < 10)
-		|| (some_parse_vec.back().next_tok != &Tok::RBracket))
+		|| (some_parse_vec.back().next_tok_kind != TokKind::RBracket))
 	{
 		return false;
 	}
@@ -1619,9 +3023,9 @@ bool Assembler::__parse_instr_ldst_ra_rb_rc_simm12
 		return false;
 	}
 
-	regs.push_back(spvat(1).next_sym_str);
-	regs.push_back(spvat(4).next_sym_str);
-	regs.push_back(spvat(6).next_sym_str);
+	regs.push_back(spvat(1).next_num);
+	regs.push_back(spvat(4).next_num);
+	regs.push_back(spvat(6).next_num);
 
 	expr_result = better_expr(some_parse_vec, index, 
 		some_parse_vec.size() - 1);
@@ -1631,15 +3035,15 @@ bool Assembler::__parse_instr_ldst_ra_rb_rc_simm12
 	return true;
 }
 bool Assembler::__parse_instr_ldst_ra_rb_rc
-	(const std::vector<ParseNode>& some_parse_vec, PInstr instr)
+	(ParseSpan some_parse_vec, PInstr instr)
 {
-	std::vector<std::string> regs;
+	RegList regs;
 	size_t index = 1;
 	s64 expr_result = 0;
 
 	// op rA , [ rB , rC ]
 	if ((some_parse_vec.size() != 8)
-		|| (some_parse_vec.back().next_tok != &Tok::RBracket))
+		|| (some_parse_vec.back().next_tok_kind != TokKind::RBracket))
 	{
 		return false;
 	}
@@ -1654,24 +3058,24 @@ bool Assembler::__parse_instr_ldst_ra_rb_rc
 		return false;
 	}
 
-	regs.push_back(spvat(1).next_sym_str);
-	regs.push_back(spvat(4).next_sym_str);
-	regs.push_back(spvat(6).next_sym_str);
+	regs.push_back(spvat(1).next_num);
+	regs.push_back(spvat(4).next_num);
+	regs.push_back(spvat(6).next_num);
 
 	__codegen.encode_and_gen(regs, expr_result, instr);
 
 	return true;
 }
 bool Assembler::__parse_instr_ldst_ra_rb_simm12
-	(const std::vector<ParseNode>& some_parse_vec, PInstr instr)
+	(ParseSpan some_parse_vec, PInstr instr)
 {
-	std::vector<std::string> regs;
+	RegList regs;
 	size_t index = 1;
 	s64 expr_result = 0;
 
 	// op rA , [ rB , expr ]
 	if ((some_parse_vec.size() < 8)
-		|| (some_parse_vec.back().next_tok != &Tok::RBracket))
+		|| (some_parse_vec.back().next_tok_kind != TokKind::RBracket))
 	{
 		return false;
 	}
@@ -1683,8 +3087,8 @@ bool Assembler::__parse_instr_ldst_ra_rb_simm12
 		return false;
 	}
 
-	regs.push_back(spvat(1).next_sym_str);
-	regs.push_back(spvat(4).next_sym_str);
+	regs.push_back(spvat(1).next_num);
+	regs.push_back(spvat(4).next_num);
 
 	expr_result = better_expr(some_parse_vec, index,
 		some_parse_vec.size() - 1);
@@ -1696,9 +3100,9 @@ bool Assembler::__parse_instr_ldst_ra_rb_simm12
 
 
 bool Assembler::__parse_instr_branch
-	(const std::vector<ParseNode>& some_parse_vec, PInstr instr)
+	(ParseSpan some_parse_vec, PInstr instr)
 {
-	std::vector<std::string> regs;
+	RegList regs;
 	size_t index = 1;
 	s64 expr_result = 0;
 
@@ -1708,26 +3112,8 @@ bool Assembler::__parse_instr_branch
 		return false;
 	}
 
-	expr_result = better_expr(some_parse_vec, index) - addr();
-
-	switch (instr->enc_group())
-	{
-		case 0:
-			expr_result -= 2;
-			break;
-
-		case 1:
-			expr_result -= 4;
-			break;
-
-		case 2:
-			expr_result -= 4;
-			break;
-
-		case 3:
-			expr_result -= 6;
-			break;
-	}
+	expr_result = better_expr(some_parse_vec, index) - addr()
+		- instr->size();
 
 
 	__codegen.encode_and_gen(regs, expr_result, instr);
@@ -1737,15 +3123,15 @@ bool Assembler::__parse_instr_branch
 
 
 bool Assembler::__parse_instr_ldst_ra_rb_imm32
-	(const std::vector<ParseNode>& some_parse_vec, PInstr instr)
+	(ParseSpan some_parse_vec, PInstr instr)
 {
-	std::vector<std::string> regs;
+	RegList regs;
 	size_t index = 1;
 	s64 expr_result = 0;
 
 	// op rA , [ rB , expr ]
 	if ((some_parse_vec.size() < 8)
-		|| (some_parse_vec.back().next_tok != &Tok::RBracket))
+		|| (some_parse_vec.back().next_tok_kind != TokKind::RBracket))
 	{
 		return false;
 	}
@@ -1757,8 +3143,8 @@ bool Assembler::__parse_instr_ldst_ra_rb_imm32
 		return false;
 	}
 
-	regs.push_back(spvat(1).next_sym_str);
-	regs.push_back(spvat(4).next_sym_str);
+	regs.push_back(spvat(1).next_num);
+	regs.push_back(spvat(4).next_num);
 
 	expr_result = better_expr(some_parse_vec, index,
 		some_parse_vec.size() - 1);
@@ -1768,9 +3154,9 @@ bool Assembler::__parse_instr_ldst_ra_rb_imm32
 	return true;
 }
 bool Assembler::__parse_instr_ra_rb_imm32
-	(const std::vector<ParseNode>& some_parse_vec, PInstr instr)
+	(ParseSpan some_parse_vec, PInstr instr)
 {
-	std::vector<std::string> regs;
+	RegList regs;
 	size_t index = 1;
 	s64 expr_result = 0;
 
@@ -1786,8 +3172,8 @@ bool Assembler::__parse_instr_ra_rb_imm32
 		return false;
 	}
 
-	regs.push_back(spvat(1).next_sym_str);
-	regs.push_back(spvat(3).next_sym_str);
+	regs.push_back(spvat(1).next_num);
+	regs.push_back(spvat(3).next_num);
 
 
 	expr_result = better_expr(some_parse_vec, index);
@@ -1800,9 +3186,9 @@ bool Assembler::__parse_instr_ra_rb_imm32
 
 // Block moves (ldmia, stmia, stmdb) with number of {} args
 bool Assembler::__parse_instr_ldst_block_1_to_4
-	(const std::vector<ParseNode>& some_parse_vec, PInstr instr)
+	(ParseSpan some_parse_vec, PInstr instr)
 {
-	std::vector<std::string> regs;
+	RegList regs;
 	size_t index = 1;
 	s64 expr_result = 0;
 
@@ -1815,17 +3201,17 @@ bool Assembler::__parse_instr_ldst_block_1_to_4
 		const auto node4 = spvat(index++);
 		const auto node5 = spvat(index++);
 
-		if ((node1.next_tok != &Tok::Reg)
-			|| (node2.next_tok != &Tok::Comma)
-			|| (node3.next_tok != &Tok::LBrace)
-			|| (node4.next_tok != &Tok::Reg)
-			|| (node5.next_tok != &Tok::RBrace))
+		if ((node1.next_tok_kind != TokKind::Reg)
+			|| (node2.next_tok_kind != TokKind::Comma)
+			|| (node3.next_tok_kind != TokKind::LBrace)
+			|| (node4.next_tok_kind != TokKind::Reg)
+			|| (node5.next_tok_kind != TokKind::RBrace))
 		{
 			return false;
 		}
 
-		regs.push_back(node1.next_sym_str);
-		regs.push_back(node4.next_sym_str);
+		regs.push_back(node1.next_num);
+		regs.push_back(node4.next_num);
 	}
 
 	// op rA , { rB , rC }
@@ -1839,20 +3225,20 @@ bool Assembler::__parse_instr_ldst_block_1_to_4
 		const auto node6 = spvat(index++);
 		const auto node7 = spvat(index++);
 
-		if ((node1.next_tok != &Tok::Reg)
-			|| (node2.next_tok != &Tok::Comma)
-			|| (node3.next_tok != &Tok::LBrace)
-			|| (node4.next_tok != &Tok::Reg)
-			|| (node5.next_tok != &Tok::Comma)
-			|| (node6.next_tok != &Tok::Reg)
-			|| (node7.next_tok != &Tok::RBrace))
+		if ((node1.next_tok_kind != TokKind::Reg)
+			|| (node2.next_tok_kind != TokKind::Comma)
+			|| (node3.next_tok_kind != TokKind::LBrace)
+			|| (node4.next_tok_kind != TokKind::Reg)
+			|| (node5.next_tok_kind != TokKind::Comma)
+			|| (node6.next_tok_kind != TokKind::Reg)
+			|| (node7.next_tok_kind != TokKind::RBrace))
 		{
 			return false;
 		}
 
-		regs.push_back(node1.next_sym_str);
-		regs.push_back(node4.next_sym_str);
-		regs.push_back(node6.next_sym_str);
+		regs.push_back(node1.next_num);
+		regs.push_back(node4.next_num);
+		regs.push_back(node6.next_num);
 	}
 	// op rA , { rB , rC , rD }
 	else if (some_parse_vec.size() == 10)
@@ -1867,23 +3253,23 @@ bool Assembler::__parse_instr_ldst_block_1_to_4
 		const auto node8 = spvat(index++);
 		const auto node9 = spvat(index++);
 
-		if ((node1.next_tok != &Tok::Reg)
-			|| (node2.next_tok != &Tok::Comma)
-			|| (node3.next_tok != &Tok::LBrace)
-			|| (node4.next_tok != &Tok::Reg)
-			|| (node5.next_tok != &Tok::Comma)
-			|| (node6.next_tok != &Tok::Reg)
-			|| (node7.next_tok != &Tok::Comma)
-			|| (node8.next_tok != &Tok::Reg)
-			|| (node9.next_tok != &Tok::RBrace))
+		if ((node1.next_tok_kind != TokKind::Reg)
+			|| (node2.next_tok_kind != TokKind::Comma)
+			|| (node3.next_tok_kind != TokKind::LBrace)
+			|| (node4.next_tok_kind != TokKind::Reg)
+			|| (node5.next_tok_kind != TokKind::Comma)
+			|| (node6.next_tok_kind != TokKind::Reg)
+			|| (node7.next_tok_kind != TokKind::Comma)
+			|| (node8.next_tok_kind != TokKind::Reg)
+			|| (node9.next_tok_kind != TokKind::RBrace))
 		{
 			return false;
 		}
 
-		regs.push_back(node1.next_sym_str);
-		regs.push_back(node4.next_sym_str);
-		regs.push_back(node6.next_sym_str);
-		regs.push_back(node8.next_sym_str);
+		regs.push_back(node1.next_num);
+		regs.push_back(node4.next_num);
+		regs.push_back(node6.next_num);
+		regs.push_back(node8.next_num);
 	}
 	// op rA , { rB , rC , rD , rE }
 	else if (some_parse_vec.size() == 12)
@@ -1900,26 +3286,26 @@ bool Assembler::__parse_instr_ldst_block_1_to_4
 		const auto node10 = spvat(index++);
 		const auto node11 = spvat(index++);
 
-		if ((node1.next_tok != &Tok::Reg)
-			|| (node2.next_tok != &Tok::Comma)
-			|| (node3.next_tok != &Tok::LBrace)
-			|| (node4.next_tok != &Tok::Reg)
-			|| (node5.next_tok != &Tok::Comma)
-			|| (node6.next_tok != &Tok::Reg)
-			|| (node7.next_tok != &Tok::Comma)
-			|| (node8.next_tok != &Tok::Reg)
-			|| (node9.next_tok != &Tok::Comma)
-			|| (node10.next_tok != &Tok::Reg)
-			|| (node11.next_tok != &Tok::RBrace))
+		if ((node1.next_tok_kind != TokKind::Reg)
+			|| (node2.next_tok_kind != TokKind::Comma)
+			|| (node3.next_tok_kind != TokKind::LBrace)
+			|| (node4.next_tok_kind != TokKind::Reg)
+			|| (node5.next_tok_kind != TokKind::Comma)
+			|| (node6.next_tok_kind != TokKind::Reg)
+			|| (node7.next_tok_kind != TokKind::Comma)
+			|| (node8.next_tok_kind != TokKind::Reg)
+			|| (node9.next_tok_kind != TokKind::Comma)
+			|| (node10.next_tok_kind != TokKind::Reg)
+			|| (node11.next_tok_kind != TokKind::RBrace))
 		{
 			return false;
 		}
 
-		regs.push_back(node1.next_sym_str);
-		regs.push_back(node4.next_sym_str);
-		regs.push_back(node6.next_sym_str);
-		regs.push_back(node8.next_sym_str);
-		regs.push_back(node10.next_sym_str);
+		regs.push_back(node1.next_num);
+		regs.push_back(node4.next_num);
+		regs.push_back(node6.next_num);
+		regs.push_back(node8.next_num);
+		regs.push_back(node10.next_num);
 	}
 	else
 	{
@@ -1931,9 +3317,9 @@ bool Assembler::__parse_instr_ldst_block_1_to_4
 	return true;
 }
 bool Assembler::__parse_instr_ldst_block_5_to_8
-	(const std::vector<ParseNode>& some_parse_vec, PInstr instr)
+	(ParseSpan some_parse_vec, PInstr instr)
 {
-	std::vector<std::string> regs;
+	RegList regs;
 	size_t index = 1;
 	s64 expr_result = 0;
 
@@ -1954,29 +3340,29 @@ bool Assembler::__parse_instr_ldst_block_5_to_8
 		const auto node12 = spvat(index++);
 		const auto node13 = spvat(index++);
 
-		if ((node1.next_tok != &Tok::Reg)
-			|| (node2.next_tok != &Tok::Comma)
-			|| (node3.next_tok != &Tok::LBrace)
-			|| (node4.next_tok != &Tok::Reg)
-			|| (node5.next_tok != &Tok::Comma)
-			|| (node6.next_tok != &Tok::Reg)
-			|| (node7.next_tok != &Tok::Comma)
-			|| (node8.next_tok != &Tok::Reg)
-			|| (node9.next_tok != &Tok::Comma)
-			|| (node10.next_tok != &Tok::Reg)
-			|| (node11.next_tok != &Tok::Comma)
-			|| (node12.next_tok != &Tok::Reg)
-			|| (node13.next_tok != &Tok::RBrace))
+		if ((node1.next_tok_kind != TokKind::Reg)
+			|| (node2.next_tok_kind != TokKind::Comma)
+			|| (node3.next_tok_kind != TokKind::LBrace)
+			|| (node4.next_tok_kind != TokKind::Reg)
+			|| (node5.next_tok_kind != TokKind::Comma)
+			|| (node6.next_tok_kind != TokKind::Reg)
+			|| (node7.next_tok_kind != TokKind::Comma)
+			|| (node8.next_tok_kind != TokKind::Reg)
+			|| (node9.next_tok_kind != TokKind::Comma)
+			|| (node10.next_tok_kind != TokKind::Reg)
+			|| (node11.next_tok_kind != TokKind::Comma)
+			|| (node12.next_tok_kind != TokKind::Reg)
+			|| (node13.next_tok_kind != TokKind::RBrace))
 		{
 			return false;
 		}
 
-		regs.push_back(node1.next_sym_str);
-		regs.push_back(node4.next_sym_str);
-		regs.push_back(node6.next_sym_str);
-		regs.push_back(node8.next_sym_str);
-		regs.push_back(node10.next_sym_str);
-		regs.push_back(node12.next_sym_str);
+		regs.push_back(node1.next_num);
+		regs.push_back(node4.next_num);
+		regs.push_back(node6.next_num);
+		regs.push_back(node8.next_num);
+		regs.push_back(node10.next_num);
+		regs.push_back(node12.next_num);
 	}
 	// op rA , { rB , rC , rD , rE , rF , rG }
 	else if (some_parse_vec.size() == 16)
@@ -1997,32 +3383,32 @@ bool Assembler::__parse_instr_ldst_block_5_to_8
 		const auto node14 = spvat(index++);
 		const auto node15 = spvat(index++);
 
-		if ((node1.next_tok != &Tok::Reg)
-			|| (node2.next_tok != &Tok::Comma)
-			|| (node3.next_tok != &Tok::LBrace)
-			|| (node4.next_tok != &Tok::Reg)
-			|| (node5.next_tok != &Tok::Comma)
-			|| (node6.next_tok != &Tok::Reg)
-			|| (node7.next_tok != &Tok::Comma)
-			|| (node8.next_tok != &Tok::Reg)
-			|| (node9.next_tok != &Tok::Comma)
-			|| (node10.next_tok != &Tok::Reg)
-			|| (node11.next_tok != &Tok::Comma)
-			|| (node12.next_tok != &Tok::Reg)
-			|| (node13.next_tok != &Tok::Comma)
-			|| (node14.next_tok != &Tok::Reg)
-			|| (node15.next_tok != &Tok::RBrace))
+		if ((node1.next_tok_kind != TokKind::Reg)
+			|| (node2.next_tok_kind != TokKind::Comma)
+			|| (node3.next_tok_kind != TokKind::LBrace)
+			|| (node4.next_tok_kind != TokKind::Reg)
+			|| (node5.next_tok_kind != TokKind::Comma)
+			|| (node6.next_tok_kind != TokKind::Reg)
+			|| (node7.next_tok_kind != TokKind::Comma)
+			|| (node8.next_tok_kind != TokKind::Reg)
+			|| (node9.next_tok_kind != TokKind::Comma)
+			|| (node10.next_tok_kind != TokKind::Reg)
+			|| (node11.next_tok_kind != TokKind::Comma)
+			|| (node12.next_tok_kind != TokKind::Reg)
+			|| (node13.next_tok_kind != TokKind::Comma)
+			|| (node14.next_tok_kind != TokKind::Reg)
+			|| (node15.next_tok_kind != TokKind::RBrace))
 		{
 			return false;
 		}
 
-		regs.push_back(node1.next_sym_str);
-		regs.push_back(node4.next_sym_str);
-		regs.push_back(node6.next_sym_str);
-		regs.push_back(node8.next_sym_str);
-		regs.push_back(node10.next_sym_str);
-		regs.push_back(node12.next_sym_str);
-		regs.push_back(node14.next_sym_str);
+		regs.push_back(node1.next_num);
+		regs.push_back(node4.next_num);
+		regs.push_back(node6.next_num);
+		regs.push_back(node8.next_num);
+		regs.push_back(node10.next_num);
+		regs.push_back(node12.next_num);
+		regs.push_back(node14.next_num);
 	}
 	// op rA , { rB , rC , rD , rE , rF , rG , rH }
 	else if (some_parse_vec.size() == 18)
@@ -2045,35 +3431,35 @@ bool Assembler::__parse_instr_ldst_block_5_to_8
 		const auto node16 = spvat(index++);
 		const auto node17 = spvat(index++);
 
-		if ((node1.next_tok != &Tok::Reg)
-			|| (node2.next_tok != &Tok::Comma)
-			|| (node3.next_tok != &Tok::LBrace)
-			|| (node4.next_tok != &Tok::Reg)
-			|| (node5.next_tok != &Tok::Comma)
-			|| (node6.next_tok != &Tok::Reg)
-			|| (node7.next_tok != &Tok::Comma)
-			|| (node8.next_tok != &Tok::Reg)
-			|| (node9.next_tok != &Tok::Comma)
-			|| (node10.next_tok != &Tok::Reg)
-			|| (node11.next_tok != &Tok::Comma)
-			|| (node12.next_tok != &Tok::Reg)
-			|| (node13.next_tok != &Tok::Comma)
-			|| (node14.next_tok != &Tok::Reg)
-			|| (node15.next_tok != &Tok::Comma)
-			|| (node16.next_tok != &Tok::Reg)
-			|| (node17.next_tok != &Tok::RBrace))
+		if ((node1.next_tok_kind != TokKind::Reg)
+			|| (node2.next_tok_kind != TokKind::Comma)
+			|| (node3.next_tok_kind != TokKind::LBrace)
+			|| (node4.next_tok_kind != TokKind::Reg)
+			|| (node5.next_tok_kind != TokKind::Comma)
+			|| (node6.next_tok_kind != TokKind::Reg)
+			|| (node7.next_tok_kind != TokKind::Comma)
+			|| (node8.next_tok_kind != TokKind::Reg)
+			|| (node9.next_tok_kind != TokKind::Comma)
+			|| (node10.next_tok_kind != TokKind::Reg)
+			|| (node11.next_tok_kind != TokKind::Comma)
+			|| (node12.next_tok_kind != TokKind::Reg)
+			|| (node13.next_tok_kind != TokKind::Comma)
+			|| (node14.next_tok_kind != TokKind::Reg)
+			|| (node15.next_tok_kind != TokKind::Comma)
+			|| (node16.next_tok_kind != TokKind::Reg)
+			|| (node17.next_tok_kind != TokKind::RBrace))
 		{
 			return false;
 		}
 
-		regs.push_back(node1.next_sym_str);
-		regs.push_back(node4.next_sym_str);
-		regs.push_back(node6.next_sym_str);
-		regs.push_back(node8.next_sym_str);
-		regs.push_back(node10.next_sym_str);
-		regs.push_back(node12.next_sym_str);
-		regs.push_back(node14.next_sym_str);
-		regs.push_back(node16.next_sym_str);
+		regs.push_back(node1.next_num);
+		regs.push_back(node4.next_num);
+		regs.push_back(node6.next_num);
+		regs.push_back(node8.next_num);
+		regs.push_back(node10.next_num);
+		regs.push_back(node12.next_num);
+		regs.push_back(node14.next_num);
+		regs.push_back(node16.next_num);
 	}
 	// op rA , { rB , rC , rD , rE , rF , rG , rH , rI }
 	else if (some_parse_vec.size() == 20)
@@ -2098,38 +3484,38 @@ bool Assembler::__parse_instr_ldst_block_5_to_8
 		const auto node18 = spvat(index++);
 		const auto node19 = spvat(index++);
 
-		if ((node1.next_tok != &Tok::Reg)
-			|| (node2.next_tok != &Tok::Comma)
-			|| (node3.next_tok != &Tok::LBrace)
-			|| (node4.next_tok != &Tok::Reg)
-			|| (node5.next_tok != &Tok::Comma)
-			|| (node6.next_tok != &Tok::Reg)
-			|| (node7.next_tok != &Tok::Comma)
-			|| (node8.next_tok != &Tok::Reg)
-			|| (node9.next_tok != &Tok::Comma)
-			|| (node10.next_tok != &Tok::Reg)
-			|| (node11.next_tok != &Tok::Comma)
-			|| (node12.next_tok != &Tok::Reg)
-			|| (node13.next_tok != &Tok::Comma)
-			|| (node14.next_tok != &Tok::Reg)
-			|| (node15.next_tok != &Tok::Comma)
-			|| (node16.next_tok != &Tok::Reg)
-			|| (node17.next_tok != &Tok::Comma)
-			|| (node18.next_tok != &Tok::Reg)
-			|| (node19.next_tok != &Tok::RBrace))
+		if ((node1.next_tok_kind != TokKind::Reg)
+			|| (node2.next_tok_kind != TokKind::Comma)
+			|| (node3.next_tok_kind != TokKind::LBrace)
+			|| (node4.next_tok_kind != TokKind::Reg)
+			|| (node5.next_tok_kind != TokKind::Comma)
+			|| (node6.next_tok_kind != TokKind::Reg)
+			|| (node7.next_tok_kind != TokKind::Comma)
+			|| (node8.next_tok_kind != TokKind::Reg)
+			|| (node9.next_tok_kind != TokKind::Comma)
+			|| (node10.next_tok_kind != TokKind::Reg)
+			|| (node11.next_tok_kind != TokKind::Comma)
+			|| (node12.next_tok_kind != TokKind::Reg)
+			|| (node13.next_tok_kind != TokKind::Comma)
+			|| (node14.next_tok_kind != TokKind::Reg)
+			|| (node15.next_tok_kind != TokKind::Comma)
+			|| (node16.next_tok_kind != TokKind::Reg)
+			|| (node17.next_tok_kind != TokKind::Comma)
+			|| (node18.next_tok_kind != TokKind::Reg)
+			|| (node19.next_tok_kind != TokKind::RBrace))
 		{
 			return false;
 		}
 
-		regs.push_back(node1.next_sym_str);
-		regs.push_back(node4.next_sym_str);
-		regs.push_back(node6.next_sym_str);
-		regs.push_back(node8.next_sym_str);
-		regs.push_back(node10.next_sym_str);
-		regs.push_back(node12.next_sym_str);
-		regs.push_back(node14.next_sym_str);
-		regs.push_back(node16.next_sym_str);
-		regs.push_back(node18.next_sym_str);
+		regs.push_back(node1.next_num);
+		regs.push_back(node4.next_num);
+		regs.push_back(node6.next_num);
+		regs.push_back(node8.next_num);
+		regs.push_back(node10.next_num);
+		regs.push_back(node12.next_num);
+		regs.push_back(node14.next_num);
+		regs.push_back(node16.next_num);
+		regs.push_back(node18.next_num);
 	}
 	else
 	{
@@ -2142,9 +3528,9 @@ bool Assembler::__parse_instr_ldst_block_5_to_8
 }
 
 bool Assembler::__parse_instr_ira
-	(const std::vector<ParseNode>& some_parse_vec, PInstr instr)
+	(ParseSpan some_parse_vec, PInstr instr)
 {
-	std::vector<std::string> regs;
+	RegList regs;
 	size_t index = 1;
 	s64 expr_result = 0;
 
@@ -2164,9 +3550,9 @@ bool Assembler::__parse_instr_ira
 	return true;
 }
 bool Assembler::__parse_instr_ra_ira
-	(const std::vector<ParseNode>& some_parse_vec, PInstr instr)
+	(ParseSpan some_parse_vec, PInstr instr)
 {
-	std::vector<std::string> regs;
+	RegList regs;
 	size_t index = 1;
 	s64 expr_result = 0;
 
@@ -2183,16 +3569,16 @@ bool Assembler::__parse_instr_ra_ira
 		return false;
 	}
 
-	regs.push_back(spvat(1).next_sym_str);
+	regs.push_back(spvat(1).next_num);
 
 	__codegen.encode_and_gen(regs, expr_result, instr);
 
 	return true;
 }
 bool Assembler::__parse_instr_ira_ra
-	(const std::vector<ParseNode>& some_parse_vec, PInstr instr)
+	(ParseSpan some_parse_vec, PInstr instr)
 {
-	std::vector<std::string> regs;
+	RegList regs;
 	size_t index = 1;
 	s64 expr_result = 0;
 
@@ -2208,7 +3594,7 @@ bool Assembler::__parse_instr_ira_ra
 		return false;
 	}
 
-	regs.push_back(spvat(3).next_sym_str);
+	regs.push_back(spvat(3).next_num);
 
 	__codegen.encode_and_gen(regs, expr_result, instr);
 
@@ -2216,9 +3602,9 @@ bool Assembler::__parse_instr_ira_ra
 }
 
 bool Assembler::__parse_instr_ra_flags
-	(const std::vector<ParseNode>& some_parse_vec, PInstr instr)
+	(ParseSpan some_parse_vec, PInstr instr)
 {
-	std::vector<std::string> regs;
+	RegList regs;
 	size_t index = 1;
 	s64 expr_result = 0;
 
@@ -2235,16 +3621,16 @@ bool Assembler::__parse_instr_ra_flags
 		return false;
 	}
 
-	regs.push_back(spvat(1).next_sym_str);
+	regs.push_back(spvat(1).next_num);
 
 	__codegen.encode_and_gen(regs, expr_result, instr);
 
 	return true;
 }
 bool Assembler::__parse_instr_flags
-	(const std::vector<ParseNode>& some_parse_vec, PInstr instr)
+	(ParseSpan some_parse_vec, PInstr instr)
 {
-	std::vector<std::string> regs;
+	RegList regs;
 	size_t index = 1;
 	s64 expr_result = 0;
 
@@ -2264,9 +3650,9 @@ bool Assembler::__parse_instr_flags
 	return true;
 }
 bool Assembler::__parse_instr_flags_ra
-	(const std::vector<ParseNode>& some_parse_vec, PInstr instr)
+	(ParseSpan some_parse_vec, PInstr instr)
 {
-	std::vector<std::string> regs;
+	RegList regs;
 	size_t index = 1;
 	s64 expr_result = 0;
 
@@ -2282,7 +3668,7 @@ bool Assembler::__parse_instr_flags_ra
 		return false;
 	}
 
-	regs.push_back(spvat(3).next_sym_str);
+	regs.push_back(spvat(3).next_num);
 
 	__codegen.encode_and_gen(regs, expr_result, instr);
 
@@ -2290,9 +3676,9 @@ bool Assembler::__parse_instr_flags_ra
 }
 
 bool Assembler::__parse_instr_ra_pc
-	(const std::vector<ParseNode>& some_parse_vec, PInstr instr)
+	(ParseSpan some_parse_vec, PInstr instr)
 {
-	std::vector<std::string> regs;
+	RegList regs;
 	size_t index = 1;
 	s64 expr_result = 0;
 
@@ -2309,7 +3695,7 @@ bool Assembler::__parse_instr_ra_pc
 		return false;
 	}
 
-	regs.push_back(spvat(1).next_sym_str);
+	regs.push_back(spvat(1).next_num);
 
 	__codegen.encode_and_gen(regs, expr_result, instr);
 
@@ -2317,9 +3703,9 @@ bool Assembler::__parse_instr_ra_pc
 }
 
 bool Assembler::__parse_instr_long_mul
-	(const std::vector<ParseNode>& some_parse_vec, PInstr instr)
+	(ParseSpan some_parse_vec, PInstr instr)
 {
-	std::vector<std::string> regs;
+	RegList regs;
 	size_t index = 1;
 	s64 expr_result = 0;
 
@@ -2346,25 +3732,25 @@ bool Assembler::__parse_instr_long_mul
 	}
 
 	// rA
-	regs.push_back(spvat(1).next_sym_str);
+	regs.push_back(spvat(1).next_num);
 
 	// rB
-	regs.push_back(spvat(3).next_sym_str);
+	regs.push_back(spvat(3).next_num);
 
 	// rC
-	regs.push_back(spvat(5).next_sym_str);
+	regs.push_back(spvat(5).next_num);
 
 	// rD
-	regs.push_back(spvat(7).next_sym_str);
+	regs.push_back(spvat(7).next_num);
 
 	__codegen.encode_and_gen(regs, expr_result, instr);
 
 	return true;
 }
 bool Assembler::__parse_instr_long_divmod
-	(const std::vector<ParseNode>& some_parse_vec, PInstr instr)
+	(ParseSpan some_parse_vec, PInstr instr)
 {
-	std::vector<std::string> regs;
+	RegList regs;
 	size_t index = 1;
 	s64 expr_result = 0;
 
@@ -2393,29 +3779,29 @@ bool Assembler::__parse_instr_long_divmod
 	}
 
 	// rA:rB
-	regs.push_back(spvat(1).next_sym_str);
-	regs.push_back(spvat(3).next_sym_str);
+	regs.push_back(spvat(1).next_num);
+	regs.push_back(spvat(3).next_num);
 
 	// rC:rD
-	regs.push_back(spvat(5).next_sym_str);
-	regs.push_back(spvat(7).next_sym_str);
+	regs.push_back(spvat(5).next_num);
+	regs.push_back(spvat(7).next_num);
 
 	// rE:rF
-	regs.push_back(spvat(9).next_sym_str);
-	regs.push_back(spvat(11).next_sym_str);
+	regs.push_back(spvat(9).next_num);
+	regs.push_back(spvat(11).next_num);
 
 	// rG:rH
-	regs.push_back(spvat(13).next_sym_str);
-	regs.push_back(spvat(15).next_sym_str);
+	regs.push_back(spvat(13).next_num);
+	regs.push_back(spvat(15).next_num);
 
 	__codegen.encode_and_gen(regs, expr_result, instr);
 
 	return true;
 }
 bool Assembler::__parse_instr_divmod
-	(const std::vector<ParseNode>& some_parse_vec, PInstr instr)
+	(ParseSpan some_parse_vec, PInstr instr)
 {
-	std::vector<std::string> regs;
+	RegList regs;
 	size_t index = 1;
 	s64 expr_result = 0;
 
@@ -2444,25 +3830,25 @@ bool Assembler::__parse_instr_divmod
 	}
 
 	// rA
-	regs.push_back(spvat(1).next_sym_str);
+	regs.push_back(spvat(1).next_num);
 
 	// rB
-	regs.push_back(spvat(3).next_sym_str);
+	regs.push_back(spvat(3).next_num);
 
 	// rC
-	regs.push_back(spvat(5).next_sym_str);
+	regs.push_back(spvat(5).next_num);
 
 	// rD
-	regs.push_back(spvat(7).next_sym_str);
+	regs.push_back(spvat(7).next_num);
 
 	__codegen.encode_and_gen(regs, expr_result, instr);
 
 	return true;
 }
 bool Assembler::__parse_instr_long_bitshift
-	(const std::vector<ParseNode>& some_parse_vec, PInstr instr)
+	(ParseSpan some_parse_vec, PInstr instr)
 {
-	std::vector<std::string> regs;
+	RegList regs;
 	size_t index = 1;
 	s64 expr_result = 0;
 
@@ -2488,16 +3874,16 @@ bool Assembler::__parse_instr_long_bitshift
 	}
 
 	// rA:rB
-	regs.push_back(spvat(1).next_sym_str);
-	regs.push_back(spvat(3).next_sym_str);
+	regs.push_back(spvat(1).next_num);
+	regs.push_back(spvat(3).next_num);
 
 	// rC:rD
-	regs.push_back(spvat(5).next_sym_str);
-	regs.push_back(spvat(7).next_sym_str);
+	regs.push_back(spvat(5).next_num);
+	regs.push_back(spvat(7).next_num);
 
 	// rE:rF
-	regs.push_back(spvat(9).next_sym_str);
-	regs.push_back(spvat(11).next_sym_str);
+	regs.push_back(spvat(9).next_num);
+	regs.push_back(spvat(11).next_num);
 
 	__codegen.encode_and_gen(regs, expr_result, instr);
 
@@ -2508,7 +3894,7 @@ bool Assembler::__parse_instr_long_bitshift
 #undef spvat
 
 
-s64 Assembler::better_expr(const std::vector<ParseNode>& some_parse_vec, 
+s64 Assembler::better_expr(ParseSpan some_parse_vec, 
 	size_t& index, size_t valid_end_index)
 {
 	if (valid_end_index == static_cast<size_t>(-1))
@@ -2517,6 +3903,7 @@ s64 Assembler::better_expr(const std::vector<ParseNode>& some_parse_vec,
 	}
 
 	s64 ret = __handle_expr(some_parse_vec, index);
+	__expr_reloc.addend = ret;
 
 	if (index != valid_end_index)
 	{
@@ -2526,7 +3913,7 @@ s64 Assembler::better_expr(const std::vector<ParseNode>& some_parse_vec,
 	return ret;
 }
 
-s64 Assembler::__handle_expr(const std::vector<ParseNode>& some_parse_vec, 
+s64 Assembler::__handle_expr(ParseSpan some_parse_vec, 
 	size_t& index)
 {
 	////const auto old_next_tok = next_tok();
@@ -2571,30 +3958,39 @@ s64 Assembler::__handle_expr(const std::vector<ParseNode>& some_parse_vec,
 
 
 	s64 ret = 0;
+	ExprReloc ret_reloc;
 
-	if (some_parse_vec.at(index).next_tok == &Tok::Minus)
+	if (some_parse_vec.at(index).next_tok_kind == TokKind::Minus)
 	{
 		//lex();
 		++index;
 
 		ret = -__handle_term(some_parse_vec, index);
+		__add_expr_reloc(ret_reloc, true);
 	}
-	else if (some_parse_vec.at(index).next_tok == &Tok::Plus)
+	else if (some_parse_vec.at(index).next_tok_kind == TokKind::Plus)
 	{
 		//lex();
 		++index;
 
 		ret = __handle_term(some_parse_vec, index);
+		ret_reloc = __expr_reloc;
 	}
-	else if (tok_is_ident_ish(some_parse_vec.at(index).next_tok)
-		|| (some_parse_vec.at(index).next_tok == &Tok::NatNum)
-		|| (some_parse_vec.at(index).next_tok == &Tok::LParen))
+	else if (tok_is_ident_ish(some_parse_vec.at(index))
+		|| (some_parse_vec.at(index).next_tok_kind == TokKind::NatNum)
+		|| (some_parse_vec.at(index).next_tok_kind == TokKind::LParen))
 	{
 		ret = __handle_term(some_parse_vec, index);
+		ret_reloc = __expr_reloc;
 	}
-	else if (some_parse_vec.at(index).next_tok == &Tok::Period)
+	else if (some_parse_vec.at(index).next_tok_kind == TokKind::Period)
 	{
 		ret = addr();
+
+		if (__options.object)
+		{
+			ret_reloc.target = RelocTarget::Section;
+		}
 	}
 	else
 	{
@@ -2607,15 +4003,16 @@ s64 Assembler::__handle_expr(const std::vector<ParseNode>& some_parse_vec,
 
 	if (index >= some_parse_vec.size())
 	{
+		__expr_reloc = ret_reloc;
 		return ret;
 	}
 
-	while ((some_parse_vec.at(index).next_tok == &Tok::Plus) 
-		|| (some_parse_vec.at(index).next_tok == &Tok::Minus))
+	while ((some_parse_vec.at(index).next_tok_kind == TokKind::Plus) 
+		|| (some_parse_vec.at(index).next_tok_kind == TokKind::Minus))
 	{
 		//const bool minus = (next_tok == Tok::Minus);
-		const bool minus = (some_parse_vec.at(index).next_tok 
-			== &Tok::Minus);
+		const bool minus = (some_parse_vec.at(index).next_tok_kind 
+			== TokKind::Minus);
 
 		//lex();
 		++index;
@@ -2629,17 +4026,49 @@ s64 Assembler::__handle_expr(const std::vector<ParseNode>& some_parse_vec,
 			ret += __handle_term(some_parse_vec, index);
 		}
 
+		__add_expr_reloc(ret_reloc, minus);
+
 		if (index >= some_parse_vec.size())
 		{
+			__expr_reloc = ret_reloc;
 			return ret;
 		}
 	}
 
+	__expr_reloc = ret_reloc;
 	return ret;
 
 }
 
-s64 Assembler::__handle_term(const std::vector<ParseNode>& some_parse_vec, 
+void Assembler::__add_expr_reloc(ExprReloc& ret, bool minus)
+{
+	if (__expr_reloc.target == RelocTarget::Absolute)
+	{
+		return;
+	}
+
+	// An address plus a number is still an address, and the difference
+	// between two addresses relative to the same thing is just a number
+	if (!minus && (ret.target == RelocTarget::Absolute))
+	{
+		ret = __expr_reloc;
+		return;
+	}
+	else if (minus && ret.same_target(__expr_reloc))
+	{
+		ret = ExprReloc();
+		return;
+	}
+
+	if (can_check_relocs())
+	{
+		err("Can't ", (minus ? "subtract" : "add"), " those relocatable ",
+			"values");
+	}
+	ret = ExprReloc();
+}
+
+s64 Assembler::__handle_term(ParseSpan some_parse_vec, 
 	size_t& index)
 {
 	s64 ret = __handle_factor(some_parse_vec, index);
@@ -2649,63 +4078,80 @@ s64 Assembler::__handle_term(const std::vector<ParseNode>& some_parse_vec,
 		return ret;
 	}
 
+	ExprReloc ret_reloc = __expr_reloc;
+
 	//const auto some_next_tok = some_parse_vec.at(index).next_tok;
 
-	while ((some_parse_vec.at(index).next_tok == &Tok::Mul) 
-		|| (some_parse_vec.at(index).next_tok == &Tok::Div)
-		|| (some_parse_vec.at(index).next_tok == &Tok::BitAnd) 
-		|| (some_parse_vec.at(index).next_tok == &Tok::BitOr)
-		|| (some_parse_vec.at(index).next_tok == &Tok::BitXor) 
-		|| (some_parse_vec.at(index).next_tok == &Tok::BitShL) 
-		|| (some_parse_vec.at(index).next_tok == &Tok::BitShR))
+	while ((some_parse_vec.at(index).next_tok_kind == TokKind::Mul) 
+		|| (some_parse_vec.at(index).next_tok_kind == TokKind::Div)
+		|| (some_parse_vec.at(index).next_tok_kind == TokKind::BitAnd) 
+		|| (some_parse_vec.at(index).next_tok_kind == TokKind::BitOr)
+		|| (some_parse_vec.at(index).next_tok_kind == TokKind::BitXor) 
+		|| (some_parse_vec.at(index).next_tok_kind == TokKind::BitShL) 
+		|| (some_parse_vec.at(index).next_tok_kind == TokKind::BitShR))
 	{
-		const auto old_next_tok = some_parse_vec.at(index).next_tok;
+		const TokKind old_next_tok_kind
+			= some_parse_vec.at(index).next_tok_kind;
 		//lex();
 		++index;
 
-		if (old_next_tok == &Tok::Mul)
+		if (old_next_tok_kind == TokKind::Mul)
 		{
 			ret *= __handle_factor(some_parse_vec, index);
 		}
-		else if (old_next_tok == &Tok::Div)
+		else if (old_next_tok_kind == TokKind::Div)
 		{
 			ret /= __handle_factor(some_parse_vec, index);
 		}
-		else if (old_next_tok == &Tok::BitAnd)
+		else if (old_next_tok_kind == TokKind::BitAnd)
 		{
 			ret &= __handle_factor(some_parse_vec, index);
 		}
-		else if (old_next_tok == &Tok::BitOr)
+		else if (old_next_tok_kind == TokKind::BitOr)
 		{
 			ret |= __handle_factor(some_parse_vec, index);
 		}
-		else if (old_next_tok == &Tok::BitXor)
+		else if (old_next_tok_kind == TokKind::BitXor)
 		{
 			ret ^= __handle_factor(some_parse_vec, index);
 		}
-		else if (old_next_tok == &Tok::BitShL)
+		else if (old_next_tok_kind == TokKind::BitShL)
 		{
 			ret <<= __handle_factor(some_parse_vec, index);
 		}
-		else if (old_next_tok == &Tok::BitShR)
+		else if (old_next_tok_kind == TokKind::BitShR)
 		{
 			ret >>= __handle_factor(some_parse_vec, index);
 		}
 
+		// Addresses can only be added and subtracted
+		if ((ret_reloc.target != RelocTarget::Absolute)
+			|| (__expr_reloc.target != RelocTarget::Absolute))
+		{
+			if (can_check_relocs())
+			{
+				err("Can't use \"", Tok::from_kind(old_next_tok_kind)->str(), "\" with a ",
+					"relocatable value");
+			}
+			ret_reloc = ExprReloc();
+		}
+
 
 		if (index >= some_parse_vec.size())
 		{
+			__expr_reloc = ret_reloc;
 			return ret;
 		}
 	}
 
 
+	__expr_reloc = ret_reloc;
 	return ret;
 
 
 }
 
-s64 Assembler::__handle_factor(const std::vector<ParseNode>& some_parse_vec, 
+s64 Assembler::__handle_factor(ParseSpan some_parse_vec, 
 	size_t& index)
 {
 	if (index >= some_parse_vec.size())
@@ -2714,24 +4160,52 @@ s64 Assembler::__handle_factor(const std::vector<ParseNode>& some_parse_vec,
 	}
 
 	//if (next_tok() == &Tok::NatNum)
-	if (some_parse_vec.at(index).next_tok == &Tok::NatNum)
+	if (some_parse_vec.at(index).next_tok_kind == TokKind::NatNum)
 	{
 		//s64 ret = next_num();
 		s64 ret = some_parse_vec.at(index).next_num;
 		//lex();
 		++index;
+		__expr_reloc = ExprReloc();
 		return ret;
 	}
 	//else if (next_tok() == &Tok::Ident)
 	//else if (next_tok_is_ident_ish())
-	else if (tok_is_ident_ish(some_parse_vec.at(index).next_tok))
+	else if (tok_is_ident_ish(some_parse_vec.at(index)))
 	{
-		// This works because __handle_factor() should only be called when
-		// we're not asking for a user symbol
-		const Symbol& sym = user_sym_tbl().at(some_parse_vec.at(index)
-			.next_sym_str);
+		// A symbol that hasn't been defined (yet) is 0, just like a
+		// label is before it's been seen.
+		static const Symbol undefined_sym;
+		const Symbol* sym_ptr = user_sym_tbl().find(some_parse_vec
+			.at(index).next_sym_id);
+		const Symbol& sym = (sym_ptr != nullptr) ? *sym_ptr 
+			: undefined_sym;
 		s64 ret;
 
+		if (__options.single_pass 
+			&& !sym_defined(some_parse_vec.at(index).next_sym_id))
+		{
+			set_found_forward_ref(true);
+		}
+
+		// In an object file, a symbol that's never defined comes from
+		// some other object file
+		__expr_reloc = ExprReloc();
+
+		if (__options.object)
+		{
+			if (sym_ptr == nullptr)
+			{
+				__expr_reloc.target = RelocTarget::Symbol;
+				__expr_reloc.sym_id = some_parse_vec.at(index)
+					.next_sym_id;
+			}
+			else if (sym.relocatable())
+			{
+				__expr_reloc.target = RelocTarget::Section;
+			}
+		}
+
 		switch (sym.type())
 		{
 			case SymType::Other:
@@ -2760,7 +4234,7 @@ s64 Assembler::__handle_factor(const std::vector<ParseNode>& some_parse_vec,
 	s64 ret;
 
 	//if (next_tok() != &Tok::LParen)
-	if (some_parse_vec.at(index).next_tok != &Tok::LParen)
+	if (some_parse_vec.at(index).next_tok_kind != TokKind::LParen)
 	{
 		//expected("token of type \"", Tok::NatNum.str(), "\" or \"", 
 		//	Tok::Ident.str(), "\" or \"", Tok::LParen.str(), "\"!");
@@ -2781,47 +4255,24 @@ s64 Assembler::__handle_factor(const std::vector<ParseNode>& some_parse_vec,
 
 
 
-#define TOKEN_STUFF(varname, value) \
-	else if (some_tok == &Tok::varname) \
-	{ \
-		return true; \
-	}
-
 bool Assembler::tok_is_punct(PTok some_tok) const
 {
-	if (some_tok == nullptr)
-	{
-	}
-
-	LIST_OF_PUNCT_TOKENS(TOKEN_STUFF)
-
-	return false;
+	return ((some_tok != nullptr) 
+		&& ((some_tok->props() & TokProp::Punct) != 0));
 }
 
 bool Assembler::tok_is_ident_ish(PTok some_tok) const
 {
-	if (some_tok == nullptr)
-	{
-	}
-
-	LIST_OF_IDENT_ISH_TOKENS(TOKEN_STUFF)
-
-	return false;
+	return ((some_tok != nullptr) 
+		&& ((some_tok->props() & TokProp::IdentIsh) != 0));
 }
 
 bool Assembler::tok_is_comment(PTok some_tok) const
 {
-	if (some_tok == nullptr)
-	{
-	}
-
-	LIST_OF_COMMENT_TOKENS(TOKEN_STUFF)
-
-	return false;
+	return ((some_tok != nullptr) 
+		&& ((some_tok->props() & TokProp::Comment) != 0));
 }
 
-#undef TOKEN_STUFF
-
 
 
 
@@ -12,6 +12,12 @@
 #include "lexer_class.hpp"
 #include "code_generator_class.hpp"
 #include "options_class.hpp"
+#include "bounded_queue_class.hpp"
+#include "work_stealing_pool_class.hpp"
+#include "object_file_class.hpp"
+#include "linker_class.hpp"
+#include "incremental_cache_class.hpp"
+#include "build_cache_class.hpp"
 
 
 namespace flare32
@@ -19,21 +25,108 @@ namespace flare32
 
 class Assembler
 {
+private:		// classes
+	// A line that used a label before the label was defined, so it gets
+	// assembled again once every label has its value (single-pass mode
+	// only)
+	class Fixup
+	{
+	public:		// variables
+		size_t lexed_line_index = 0;
+		size_t addr = 0;
+
+		// Which output segment the line's bytes went into
+		size_t segment_index = 0;
+
+	public:		// functions
+		inline Fixup()
+		{
+		}
+		inline Fixup(size_t s_lexed_line_index, size_t s_addr,
+			size_t s_segment_index)
+			: lexed_line_index(s_lexed_line_index), addr(s_addr),
+			segment_index(s_segment_index)
+		{
+		}
+
+		inline Fixup(const Fixup& to_copy) = default;
+		inline Fixup& operator = (const Fixup& to_copy) = default;
+	};
+
+	// What an expression's value is relative to (only ever not Absolute
+	// when assembling an object file)
+	class ExprReloc
+	{
+	public:		// variables
+		RelocTarget target = RelocTarget::Absolute;
+
+		// RelocTarget::Symbol only
+		SymId sym_id = IdentPool::bad_id;
+
+		// The whole expression's value (only set by better_expr())
+		s64 addend = 0;
+
+	public:		// functions
+		inline bool same_target(const ExprReloc& other) const
+		{
+			return ((target == other.target) && (sym_id == other.sym_id));
+		}
+	};
+
 private:		// variables
 	// Arbitrary number
 	static constexpr size_t expand_max_depth = 9001;
 	//static constexpr size_t expand_max_depth = 256;
 	//static constexpr size_t expand_max_depth = 4;
-	static constexpr s32 last_pass = 2;
+
+	// Passes before first_output_pass only find label values.  They are
+	// repeated until a whole pass goes by without any label or equate
+	// changing value, and then one more pass generates the output.
+	static constexpr s32 first_output_pass = 2;
+	static constexpr s32 max_passes = 16;
+
+	// The output pass is only split between threads if each one would
+	// get at least this many lines
+	static constexpr size_t min_lines_per_thread = 1024;
+
+	// The lexer hands lines to the first pass this many at a time, and
+	// may get at most max_batches_queued batches ahead of it
+	static constexpr size_t lines_per_batch = 256;
+	static constexpr size_t max_batches_queued = 16;
 	WarnError __we;
-	SymbolTable __builtin_sym_tbl, __user_sym_tbl;
+	SymbolTable __user_sym_tbl;
 	DefineTable __define_tbl;
 	InstructionTable __instr_tbl;
 	Lexer __lexer;
 	CodeGenerator __codegen;
 	Options __options;
+	OutputBuffer __output_buf;
+
+	// The entire input file, read in all at once
+	std::string __input;
+
+	// Each line of __input, including its '\n'
+	std::vector<std::string_view> __lines;
+
+	// Set on the Assembler that lexes another one's __lines on another
+	// thread (see lex_lines()), along with a flag telling it to stop early
+	const Assembler* __lexing_for = nullptr;
+	const std::atomic<bool>* __stop_lexing = nullptr;
 
-	std::vector<std::string> __lines;
+	// __lines, already lexed (blank and comment-only lines are left out)
+	std::vector<LexedLine> __lexed_lines;
+
+	// Every line's tokens, back to back, so that lexing the whole file
+	// doesn't need an allocation per line
+	std::vector<ParseNode> __parse_nodes;
+
+	// The address each of __lexed_lines started at in the latest pass
+	std::vector<size_t> __line_addrs;
+
+	// Which overload an operand signature picks, indexed by the
+	// mnemonic's SymId (see InstructionTable::args_match_signature())
+	std::vector<std::map<std::string, PInstr, std::less<>>>
+		__instr_by_signature;
 
 
 	// Where are we in the generated binary?
@@ -44,13 +137,55 @@ private:		// variables
 
 	int __next_char = ' ';
 	PTok __prev_tok = nullptr, __next_tok = nullptr;
-	std::string __next_sym_str;
+	SymId __next_sym_id = IdentPool::bad_id;
 	s64 __next_num = -1;
 
+	// Whether any user symbol's value is different from what it was at
+	// the end of the previous pass
 	bool __changed = false;
+	std::vector<s64> __prev_sym_values;
+
+	// Single-pass mode:  which user symbols have been defined so far, and
+	// whether the current line used one that hasn't been
+	std::vector<bool> __defined_syms;
+	bool __found_forward_ref = false;
+
+	// Whether any label or equate got defined more than once in the
+	// latest pass, in which case symbol values depend on where in the
+	// file they're used
+	bool __found_redefinition = false;
 	s32 __pass = 0;
 
 	char* __input_filename = nullptr;
+
+	// Batch and link mode's input files, in the order they were given
+	std::vector<std::string> __input_filenames;
+
+	// The latest expression's ExprReloc
+	ExprReloc __expr_reloc;
+
+	// Symbols that .global has exported from the object file
+	std::set<SymId> __global_syms;
+
+	// -i only:  what got cached last time, and what gets cached this time
+	IncrementalCache __icache, __new_icache;
+
+	// Each of __lexed_lines' IncrementalCache::hash_line()
+	std::vector<u64> __line_hashes;
+
+	// The index into __icache.lines of the line that each of
+	// __lexed_lines is the same as, or no_cached_line
+	static constexpr size_t no_cached_line = static_cast<size_t>(-1);
+	std::vector<size_t> __cached_line_indices;
+
+	// Indexed by SymId:  which symbols had a value at the end of last
+	// time, and what it was
+	std::vector<bool> __cached_sym_defined;
+	std::vector<s64> __cached_sym_values;
+
+	// Whether cached bytes can be used in this output pass
+	bool __reuse_cached_bytes = false;
+
 	std::FILE* __infile = nullptr;
 
 	int __argc;
@@ -79,7 +214,6 @@ public:		// functions
 
 
 private:		// functions
-	gen_getter_by_ref(builtin_sym_tbl);
 	gen_getter_by_ref(user_sym_tbl);
 	gen_getter_by_ref(define_tbl);
 	gen_getter_by_ref(instr_tbl);
@@ -93,9 +227,10 @@ private:		// functions
 	//gen_getter_and_setter_by_val(next_tok);
 	gen_getter_by_val(prev_tok)
 	gen_getter_by_val(next_tok)
-	gen_getter_and_setter_by_con_ref(next_sym_str);
+	gen_getter_and_setter_by_val(next_sym_id);
 	gen_getter_and_setter_by_val(next_num);
 	gen_getter_and_setter_by_val(changed);
+	gen_getter_and_setter_by_val(found_forward_ref);
 	gen_getter_and_setter_by_val(pass);
 	gen_getter_and_setter_by_val(input_filename);
 	gen_getter_and_setter_by_val(infile);
@@ -105,8 +240,117 @@ private:		// functions
 	char* parse_argv();
 
 
+	// Assembles the input file into __output_buf.  The second one is for
+	// when the file has already been read, by read_input().
+	void assemble();
+	void assemble(std::string&& some_input);
+
+	// Assembles each of __input_filenames into its own output file, on
+	// num_threads() threads, and returns the exit status
+	int batch();
+
+	// Makes this Assembler (which must not have had init() called)
+	// assemble some_filename, using some_main's options, and write the
+	// output next to it.  Errors go into ret_error instead of stopping the
+	// program.
+	void __assemble_batch_file(const Assembler& some_main,
+		std::string& some_filename, std::string& ret_error);
+	static std::string batch_output_filename
+		(const std::string& some_input_filename,
+		const Options& some_options);
+
+	// Writes __output_buf as an object file, with .global symbols as
+	// exports, and any symbol that never got defined as an import
+	void write_object(FILE* some_outfile);
+
+	// Makes sure that every .global symbol is a label or equate
+	void check_global_syms();
+
+	// Assembles infile() and writes the output (an object file or
+	// out_type) to the file that some_open_outfile() returns, which only
+	// gets called if there were no errors.  With -C, an output that's
+	// already in the BuildCache gets written without assembling (or even
+	// lexing) anything, and any other output gets stored in it.
+	void __assemble_and_write
+		(const std::function<FILE*()>& some_open_outfile);
+	void __write_output(FILE* some_outfile);
+
+	inline std::string icache_filename() const
+	{
+		return std::string(input_filename()) + ".icache";
+	}
+
+	// Works out which of __lexed_lines are the same as the ones in
+	// __icache.  Only the lines before and after the part of the file
+	// that changed are matched up, which is all that's needed for an edit
+	// in one place.
+	void __match_icache();
+	void __hash_lines();
+
+	// Returns the cached line that line some_index (which must not have
+	// been changed) can be replaced with, or nullptr if there isn't one.
+	// Only lines whose size depends on nothing but their tokens, i.e.
+	// instructions, .db, and .dw, can be.
+	const IncrementalCache::Line* __cached_line(size_t some_index) const;
+	bool __cached_sym_unchanged(SymId some_sym_id) const;
+
+	// These do the same as line() for line some_index, using the cache
+	// instead, and return false if they can't
+	bool __size_cached_line(size_t some_index);
+	bool __gen_cached_line(size_t some_index);
+
+	// The output pass, except with the cache:  lines that are the same,
+	// at the same address, using the same symbol values as last time just
+	// get last time's bytes.  Then every line gets cached for next time.
+	void __incremental_output_pass();
+
 	void reinit();
-	void fill_builtin_sym_tbl();
+	void update_changed();
+	void multi_pass();
+	void single_pass();
+	void output_pass();
+	void parallel_output_pass(size_t num_chunks);
+
+	// Makes this Assembler (which must not have had init() called) able
+	// to assemble some of some_main's lines in the output pass, on
+	// another thread.  Symbols and the like are copied, so that nothing
+	// is shared between threads other than the lines themselves.
+	void __init_worker(const Assembler& some_main);
+	void __assemble_chunk(const Assembler& some_main, size_t some_begin,
+		size_t some_end);
+
+	inline bool sym_defined(SymId some_sym_id) const
+	{
+		return ((some_sym_id < __defined_syms.size())
+			&& __defined_syms[some_sym_id]);
+	}
+	void set_sym_defined(SymId some_sym_id);
+
+	inline ParseSpan parse_span(const LexedLine& some_lexed_line) const
+	{
+		return ParseSpan(__parse_nodes.data() + some_lexed_line.first_node,
+			some_lexed_line.num_nodes);
+	}
+
+	// Returns the symbol some_sym_id, creating it with type some_type if
+	// this is its first definition.  Only definitions create symbols.
+	Symbol& define_sym(SymId some_sym_id, SymType some_type);
+
+	// .def names are created as soon as their line is lexed, and noted in
+	// some_batch so that the first pass can create them too
+	void add_define_names(ParseSpan some_parse_vec,
+		LexedBatch& some_batch);
+
+	inline size_t num_threads() const
+	{
+		return (__options.num_threads != 0) ? __options.num_threads
+			: std::thread::hardware_concurrency();
+	}
+
+	inline std::string_view sym_str(SymId some_sym_id) const
+	{
+		return __lexer.ident_pool().str(some_sym_id);
+	}
 
 
 	PTok set_next_tok(PTok n_next_tok)
@@ -138,35 +382,69 @@ private:		// functions
 		bool use_lines=false)
 	{
 		__lexer.__advance_innards(__next_char, __next_tok,
-			__next_sym_str, __next_num, __line_num, 
+			__next_sym_id, __next_num, __line_num, 
 			some_outer_index, some_inner_index,
-			(use_lines ? &__lines : nullptr));
+			(use_lines ? &lines_to_lex() : nullptr));
 	}
 	inline void lex(size_t& some_outer_index, size_t& some_inner_index,
 		bool use_lines=false)
 	{
 		__lexer.__lex_innards(__next_char, __next_tok, __prev_tok,
-			__next_sym_str, __next_num, __line_num, 
+			__next_sym_id, __next_num, __line_num, 
 			some_outer_index, some_inner_index,
-			(use_lines ? &__lines : nullptr));
+			(use_lines ? &lines_to_lex() : nullptr));
+	}
+	inline const std::vector<std::string_view>& lines_to_lex() const
+	{
+		return (__lexing_for != nullptr) ? __lexing_for->__lines
+			: __lines;
 	}
 	//inline void lex(size_t& some_outer_index, size_t& some_inner_index,
 	//	std::vector<std::string>& some_lines)
 	//{
 	//	__lex_innards(__next_char, __next_tok,
-	//		__next_sym_str, __next_num, __line_num, 
+	//		__next_sym_id, __next_num, __line_num, 
 	//		some_outer_index, some_inner_index, &some_lines);
 	//}
 
-	void print_parse_vec(const std::vector<ParseNode> some_parse_vec)
+	void print_parse_vec(ParseSpan some_parse_vec)
 		const;
 	void next_line(size_t& some_outer_index, size_t& some_inner_index,
 		std::vector<ParseNode>& some_parse_vec);
-	void line(size_t& some_outer_index, size_t& some_inner_index);
-
-	void finish_line(const std::vector<ParseNode>& some_parse_vec);
-
-	void fill_lines();
+	void line(ParseSpan parse_vec);
+
+	// If parse_vec starts with a label, defines it and returns true
+	bool handle_label(ParseSpan parse_vec);
+	bool line_has_label(ParseSpan parse_vec) const;
+
+	void finish_line(ParseSpan some_parse_vec);
+	void append_operand_signature(std::string& ret,
+		ParseSpan some_parse_vec) const;
+	PInstr find_instr(ParseSpan some_parse_vec);
+
+	// Reads the whole input file into ret, rather than one character at
+	// a time
+	void read_input(std::string& ret);
+
+	// Moves some_input into __input, and splits it into __lines
+	void fill_lines(std::string&& some_input);
+
+	// Lexes the whole file, calling some_on_line() with each lexed line's
+	// index into __lexed_lines as soon as that line is ready.  The lexing
+	// happens on another thread (unless there's only one), so the first
+	// pass can run while the rest of the file is still being lexed.
+	void lex_lines(const std::function<void(size_t)>& some_on_line);
+
+	// Makes this Assembler (which must not have had init() called) able
+	// to lex some_main's __lines on another thread.  They're only read,
+	// and some_main doesn't change them while lexing.  Once *some_stop is
+	// set, lexing ends as if the file had.
+	void __init_lexer(const Assembler& some_main,
+		const std::atomic<bool>* some_stop);
+	void __lex_batches(size_t some_lines_per_batch,
+		const std::function<void(LexedBatch&&)>& some_on_batch);
+	void __take_batch(LexedBatch&& some_batch,
+		const std::function<void(size_t)>& some_on_line);
 	//void find_defines();
 	//void expand_defines();
 
@@ -187,7 +465,7 @@ private:		// functions
 		const size_t first_line_num);
 	
 	// start_index is after "(", end_index_exclusive is ")"
-	bool handle_condition(const std::vector<ParseNode>& line_iter,
+	bool handle_condition(ParseSpan line_iter,
 		size_t start_index, const size_t end_index_exclusive);
 
 	inline void insert_comment(std::string& iter)
@@ -197,9 +475,8 @@ private:		// functions
 
 	// Directives evaluated after conditional assembly and .def, evaluated
 	// alongside labels, instructions, and comments.
-	bool handle_later_directives(size_t& some_outer_index, 
-		size_t& some_inner_index, size_t& index,
-		const std::vector<ParseNode>& parse_vec);
+	bool handle_later_directives(size_t& index,
+		ParseSpan parse_vec);
 
 
 
@@ -210,117 +487,148 @@ private:		// functions
 
 
 	bool parse_instr(PInstr instr, 
-		const std::vector<ParseNode>& some_parse_vec);
+		ParseSpan some_parse_vec);
 
 	bool __parse_instr_no_args
-		(const std::vector<ParseNode>& some_parse_vec, PInstr instr);
+		(ParseSpan some_parse_vec, PInstr instr);
 	bool __parse_instr_uimm16
-		(const std::vector<ParseNode>& some_parse_vec, PInstr instr);
+		(ParseSpan some_parse_vec, PInstr instr);
 	bool __parse_instr_simm16
-		(const std::vector<ParseNode>& some_parse_vec, PInstr instr);
+		(ParseSpan some_parse_vec, PInstr instr);
 	bool __parse_instr_imm32
-		(const std::vector<ParseNode>& some_parse_vec, PInstr instr);
+		(ParseSpan some_parse_vec, PInstr instr);
 
 	bool __parse_instr_ra
-		(const std::vector<ParseNode>& some_parse_vec, PInstr instr);
+		(ParseSpan some_parse_vec, PInstr instr);
 	bool __parse_instr_ra_uimm16
-		(const std::vector<ParseNode>& some_parse_vec, PInstr instr);
+		(ParseSpan some_parse_vec, PInstr instr);
 	bool __parse_instr_ra_rb
-		(const std::vector<ParseNode>& some_parse_vec, PInstr instr);
+		(ParseSpan some_parse_vec, PInstr instr);
 	bool __parse_instr_ra_rb_uimm16
-		(const std::vector<ParseNode>& some_parse_vec, PInstr instr);
+		(ParseSpan some_parse_vec, PInstr instr);
 	bool __parse_instr_ra_rb_simm16
-		(const std::vector<ParseNode>& some_parse_vec, PInstr instr);
+		(ParseSpan some_parse_vec, PInstr instr);
 	bool __parse_instr_ra_rb_rc
-		(const std::vector<ParseNode>& some_parse_vec, PInstr instr);
+		(ParseSpan some_parse_vec, PInstr instr);
 	bool __parse_instr_ra_rb_rc_simm12
-		(const std::vector<ParseNode>& some_parse_vec, PInstr instr);
+		(ParseSpan some_parse_vec, PInstr instr);
 
 	bool __parse_instr_ldst_ra_rb
-		(const std::vector<ParseNode>& some_parse_vec, PInstr instr);
+		(ParseSpan some_parse_vec, PInstr instr);
 	bool __parse_instr_ldst_ra_rb_rc_simm12
-		(const std::vector<ParseNode>& some_parse_vec, PInstr instr);
+		(ParseSpan some_parse_vec, PInstr instr);
 	bool __parse_instr_ldst_ra_rb_rc
-		(const std::vector<ParseNode>& some_parse_vec, PInstr instr);
+		(ParseSpan some_parse_vec, PInstr instr);
 	bool __parse_instr_ldst_ra_rb_simm12
-		(const std::vector<ParseNode>& some_parse_vec, PInstr instr);
+		(ParseSpan some_parse_vec, PInstr instr);
 
 
 	bool __parse_instr_branch
-		(const std::vector<ParseNode>& some_parse_vec, PInstr instr);
+		(ParseSpan some_parse_vec, PInstr instr);
 
 
 	bool __parse_instr_ldst_ra_rb_imm32
-		(const std::vector<ParseNode>& some_parse_vec, PInstr instr);
+		(ParseSpan some_parse_vec, PInstr instr);
 	bool __parse_instr_ra_rb_imm32
-		(const std::vector<ParseNode>& some_parse_vec, PInstr instr);
+		(ParseSpan some_parse_vec, PInstr instr);
 
 
 	// Block moves (ldmia, stmia, stmdb) with number of {} args
 	bool __parse_instr_ldst_block_1_to_4
-		(const std::vector<ParseNode>& some_parse_vec, PInstr instr);
+		(ParseSpan some_parse_vec, PInstr instr);
 	bool __parse_instr_ldst_block_5_to_8
-		(const std::vector<ParseNode>& some_parse_vec, PInstr instr);
+		(ParseSpan some_parse_vec, PInstr instr);
 
 	bool __parse_instr_ira
-		(const std::vector<ParseNode>& some_parse_vec, PInstr instr);
+		(ParseSpan some_parse_vec, PInstr instr);
 	bool __parse_instr_ra_ira
-		(const std::vector<ParseNode>& some_parse_vec, PInstr instr);
+		(ParseSpan some_parse_vec, PInstr instr);
 	bool __parse_instr_ira_ra
-		(const std::vector<ParseNode>& some_parse_vec, PInstr instr);
+		(ParseSpan some_parse_vec, PInstr instr);
 
 	bool __parse_instr_ra_flags
-		(const std::vector<ParseNode>& some_parse_vec, PInstr instr);
+		(ParseSpan some_parse_vec, PInstr instr);
 	bool __parse_instr_flags
-		(const std::vector<ParseNode>& some_parse_vec, PInstr instr);
+		(ParseSpan some_parse_vec, PInstr instr);
 	bool __parse_instr_flags_ra
-		(const std::vector<ParseNode>& some_parse_vec, PInstr instr);
+		(ParseSpan some_parse_vec, PInstr instr);
 
 	bool __parse_instr_ra_pc
-		(const std::vector<ParseNode>& some_parse_vec, PInstr instr);
+		(ParseSpan some_parse_vec, PInstr instr);
 
 
 	bool __parse_instr_long_mul
-		(const std::vector<ParseNode>& some_parse_vec, PInstr instr);
+		(ParseSpan some_parse_vec, PInstr instr);
 	bool __parse_instr_long_divmod
-		(const std::vector<ParseNode>& some_parse_vec, PInstr instr);
+		(ParseSpan some_parse_vec, PInstr instr);
 	bool __parse_instr_divmod
-		(const std::vector<ParseNode>& some_parse_vec, PInstr instr);
+		(ParseSpan some_parse_vec, PInstr instr);
 	bool __parse_instr_long_bitshift
-		(const std::vector<ParseNode>& some_parse_vec, PInstr instr);
+		(ParseSpan some_parse_vec, PInstr instr);
 
 
-	s64 better_expr(const std::vector<ParseNode>& some_parse_vec, 
+	// These all set __expr_reloc to what their result is relative to
+	s64 better_expr(ParseSpan some_parse_vec, 
 		size_t& index, size_t valid_end_index=-1);
-	s64 __handle_expr(const std::vector<ParseNode>& some_parse_vec, 
+	s64 __handle_expr(ParseSpan some_parse_vec, 
 		size_t& index);
-	s64 __handle_term(const std::vector<ParseNode>& some_parse_vec, 
+	s64 __handle_term(ParseSpan some_parse_vec, 
 		size_t& index);
-	s64 __handle_factor(const std::vector<ParseNode>& some_parse_vec, 
+	s64 __handle_factor(ParseSpan some_parse_vec, 
 		size_t& index);
 
+	// Relocation errors can only be caught once every label has been
+	// seen, and in single-pass mode, not on a line that will be patched
+	inline bool can_check_relocs() const
+	{
+		return ((pass() >= first_output_pass) && !found_forward_ref());
+	}
+
+	// Combines ret, an expression's ExprReloc so far, with __expr_reloc,
+	// the ExprReloc of the next term to be added to or subtracted from
+	// it
+	void __add_expr_reloc(ExprReloc& ret, bool minus);
+
+	// Records a relocation for the field of some_instr (which started at
+	// some_instr_addr) that __expr_reloc's expression went into
+	void __reloc_instr(PInstr some_instr, size_t some_instr_addr);
+
 	
 
+	// The PTok ones are for the lexer's next_tok().  Lexed tokens are
+	// classified straight from their ParseNode's TokKind.
 	bool tok_is_punct(PTok some_tok) const;
 	bool tok_is_ident_ish(PTok some_tok) const;
 	bool tok_is_comment(PTok some_tok) const;
+	inline bool tok_is_punct(const ParseNode& some_node) const
+	{
+		return ((some_node.next_tok_props() & TokProp::Punct) != 0);
+	}
+	inline bool tok_is_ident_ish(const ParseNode& some_node) const
+	{
+		return ((some_node.next_tok_props() & TokProp::IdentIsh) != 0);
+	}
+	inline bool tok_is_comment(const ParseNode& some_node) const
+	{
+		return ((some_node.next_tok_props() & TokProp::Comment) != 0);
+	}
 
 
 	bool __check_tokens_innards
-		(const std::vector<ParseNode>& some_parse_vec, size_t index, 
+		(ParseSpan some_parse_vec, size_t index, 
 		PTok tok) const
 	{
-		return (some_parse_vec.at(index).next_tok == tok);
+		return (some_parse_vec.at(index).next_tok_kind == tok->kind());
 	}
 
-	inline bool check_tokens(const std::vector<ParseNode>& some_parse_vec,
+	inline bool check_tokens(ParseSpan some_parse_vec,
 		size_t& index) const
 	{
 		return true;
 	}
 
 	template<typename... RemArgTypes>
-	bool check_tokens(const std::vector<ParseNode>& some_parse_vec,
+	bool check_tokens(ParseSpan some_parse_vec,
 		size_t& index, PTok tok, RemArgTypes&&... rem_args) const
 	{
 		if (__check_tokens_innards(some_parse_vec, index++, tok))
@@ -0,0 +1,110 @@
+#ifndef binary_file_funcs_hpp
+#define binary_file_funcs_hpp
+
+#include "misc_includes.hpp"
+
+// Little-endian numbers for the assembler's own binary files (object files
+// and the incremental cache).  Files are built up in memory and written
+// with one fwrite(), and read all at once.
+
+namespace flare32
+{
+
+inline void append_u8(std::string& data, u8 v)
+{
+	data += static_cast<char>(v);
+}
+inline void append_u32(std::string& data, u32 v)
+{
+	for (size_t i=0; i<4; ++i)
+	{
+		append_u8(data, v >> (i * 8));
+	}
+}
+inline void append_u64(std::string& data, u64 v)
+{
+	append_u32(data, v);
+	append_u32(data, v >> 32);
+}
+
+inline void read_whole_file(FILE* some_infile, std::string& ret)
+{
+	char buf[1 << 16];
+	size_t size;
+
+	ret.clear();
+
+	while ((size = fread(buf, 1, sizeof(buf), some_infile)) > 0)
+	{
+		ret.append(buf, size);
+	}
+}
+
+// Reads from a file's contents, remembering if it ever ran out
+class BinaryReader
+{
+private:		// variables
+	const std::string& __data;
+	size_t __index = 0;
+	bool __ok = true;
+
+public:		// functions
+	inline BinaryReader(const std::string& s_data)
+		: __data(s_data)
+	{
+	}
+
+	inline u8 read_u8()
+	{
+		if (__index >= __data.size())
+		{
+			__ok = false;
+			return 0;
+		}
+
+		return static_cast<u8>(__data[__index++]);
+	}
+	inline u32 read_u32()
+	{
+		u32 ret = 0;
+
+		for (size_t i=0; i<4; ++i)
+		{
+			ret |= static_cast<u32>(read_u8()) << (i * 8);
+		}
+
+		return ret;
+	}
+	inline u64 read_u64()
+	{
+		const u64 low = read_u32();
+		return low | (static_cast<u64>(read_u32()) << 32);
+	}
+
+	// Returns false (and reads nothing) if there aren't some_size bytes
+	// left
+	inline bool read_bytes(size_t some_size, std::string_view& ret)
+	{
+		if (some_size > (__data.size() - __index))
+		{
+			__ok = false;
+			return false;
+		}
+
+		ret = std::string_view(__data).substr(__index, some_size);
+		__index += some_size;
+		return true;
+	}
+
+	inline bool at_end() const
+	{
+		return (__index == __data.size());
+	}
+
+	gen_getter_by_val(ok)
+};
+
+}
+
+
+#endif		// binary_file_funcs_hpp
@@ -0,0 +1,69 @@
+#ifndef bounded_queue_class_hpp
+#define bounded_queue_class_hpp
+
+#include "misc_includes.hpp"
+
+namespace flare32
+{
+
+// A fixed-size, lock-free queue between exactly one producer thread and
+// exactly one consumer thread.  push() waits while the queue is full and
+// pop() waits while it's empty, so the producer can't get too far ahead.
+template<typename Type, size_t capacity>
+class BoundedQueue
+{
+private:		// constants
+	static_assert((capacity != 0) && ((capacity & (capacity - 1)) == 0),
+		"BoundedQueue capacity must be a power of two");
+
+private:		// variables
+	std::array<Type, capacity> __items;
+
+	// Both only ever go up; the producer only writes __tail, and the
+	// consumer only writes __head.  They're kept on separate cache lines.
+	alignas(64) std::atomic<size_t> __head{0};
+	alignas(64) std::atomic<size_t> __tail{0};
+
+public:		// functions
+	inline BoundedQueue()
+	{
+	}
+
+	BoundedQueue(const BoundedQueue& to_copy) = delete;
+	BoundedQueue& operator = (const BoundedQueue& to_copy) = delete;
+
+	// Producer only
+	inline void push(Type&& to_push)
+	{
+		const size_t tail = __tail.load(std::memory_order_relaxed);
+
+		while ((tail - __head.load(std::memory_order_acquire))
+			== capacity)
+		{
+			std::this_thread::yield();
+		}
+
+		__items[tail & (capacity - 1)] = std::move(to_push);
+		__tail.store(tail + 1, std::memory_order_release);
+	}
+
+	// Consumer only
+	inline Type pop()
+	{
+		const size_t head = __head.load(std::memory_order_relaxed);
+
+		while (__tail.load(std::memory_order_acquire) == head)
+		{
+			std::this_thread::yield();
+		}
+
+		Type ret = std::move(__items[head & (capacity - 1)]);
+		__head.store(head + 1, std::memory_order_release);
+		return ret;
+	}
+};
+
+}
+
+
+#endif		// bounded_queue_class_hpp
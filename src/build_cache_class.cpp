@@ -0,0 +1,96 @@
+#include "build_cache_class.hpp"
+#include <random>
+
+namespace flare32
+{
+
+bool BuildCache::find(const std::string& some_source,
+	const Options& some_options, std::string& ret) const
+{
+	const std::string key = __key(some_source, some_options);
+	FILE* infile = fopen(__filename(key).c_str(), "rb");
+
+	if (infile == nullptr)
+	{
+		return false;
+	}
+
+	std::string file_data;
+	read_whole_file(infile, file_data);
+	fclose(infile);
+
+	if (std::string_view(file_data).substr(0, key.size()) != key)
+	{
+		return false;
+	}
+
+	ret = file_data.substr(key.size());
+	return true;
+}
+
+bool BuildCache::store(const std::string& some_source,
+	const Options& some_options, const std::string& some_output) const
+{
+	const std::string key = __key(some_source, some_options);
+	const std::string filename = __filename(key);
+
+	// Write to a temporary file first, so that there's never a partly
+	// written entry around, even with other runs using the same directory
+	// at the same time
+	const std::string temp_filename = filename + "."
+		+ std::to_string(std::random_device()()) + ".tmp";
+	FILE* outfile = fopen(temp_filename.c_str(), "wb");
+
+	if (outfile == nullptr)
+	{
+		return false;
+	}
+
+	const bool ok = ((fwrite(key.data(), 1, key.size(), outfile)
+		== key.size())
+		&& (fwrite(some_output.data(), 1, some_output.size(), outfile)
+		== some_output.size()));
+
+	if ((fclose(outfile) != 0) || !ok
+		|| (std::rename(temp_filename.c_str(), filename.c_str()) != 0))
+	{
+		std::remove(temp_filename.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+std::string BuildCache::__key(const std::string& some_source,
+	const Options& some_options)
+{
+	std::string ret = magic;
+	append_u32(ret, version);
+	append_u8(ret, static_cast<u8>(some_options.out_type));
+	append_u8(ret, some_options.object);
+	append_u8(ret, some_options.single_pass);
+	append_u32(ret, some_source.size());
+	ret += some_source;
+
+	return ret;
+}
+
+std::string BuildCache::__filename(const std::string& some_key) const
+{
+	// FNV-1a
+	u64 hash = 14695981039346656037ull;
+
+	for (const char c : some_key)
+	{
+		hash ^= static_cast<u8>(c);
+		hash *= 1099511628211ull;
+	}
+
+	char hex[17];
+	snprintf(hex, sizeof(hex), "%016llx",
+		static_cast<unsigned long long>(hash));
+
+	return __dir + "/" + hex + ".f32c";
+}
+
+}
@@ -0,0 +1,54 @@
+#ifndef build_cache_class_hpp
+#define build_cache_class_hpp
+
+#include "misc_includes.hpp"
+#include "options_class.hpp"
+#include "binary_file_funcs.hpp"
+
+namespace flare32
+{
+
+// The -C option's cache of whole output files, in a directory that can be
+// shared between runs (and between machines).  Each entry is named after a
+// hash of everything that the output depends on:  the assembler's version,
+// the options that change the output, and the input file's contents.
+// Since a hash can collide, the entry also holds everything that was
+// hashed, which has to match exactly for it to be used:
+//
+//	"F32C", u32 version, u8 out_type, u8 object, u8 single_pass,
+//	u32 source_size, char source[source_size], then the output itself
+class BuildCache
+{
+private:		// constants
+	static constexpr char magic[] = "F32C";
+
+	// Change this whenever the same input could get assembled differently
+	static constexpr u32 version = 1;
+
+private:		// variables
+	std::string __dir;
+
+public:		// functions
+	inline BuildCache(const std::string& s_dir)
+		: __dir(s_dir)
+	{
+	}
+
+	// Returns false if there's no entry for some_source
+	bool find(const std::string& some_source, const Options& some_options,
+		std::string& ret) const;
+
+	// Returns false if the entry can't be written
+	bool store(const std::string& some_source, const Options& some_options,
+		const std::string& some_output) const;
+
+private:		// functions
+	static std::string __key(const std::string& some_source,
+		const Options& some_options);
+	std::string __filename(const std::string& some_key) const;
+};
+
+}
+
+
+#endif		// build_cache_class_hpp
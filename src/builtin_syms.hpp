@@ -0,0 +1,353 @@
+#ifndef builtin_syms_hpp
+#define builtin_syms_hpp
+
+#include "misc_includes.hpp"
+#include "tokens_and_stuff.hpp"
+#include "instruction_table_class.hpp"
+
+// Registers
+#define LIST_OF_BUILTIN_REGS(REG_STUFF) \
+/* General-purpose registers */ \
+REG_STUFF("r0", Reg, 0) \
+REG_STUFF("r1", Reg, 1) \
+REG_STUFF("r2", Reg, 2) \
+REG_STUFF("r3", Reg, 3) \
+REG_STUFF("r4", Reg, 4) \
+REG_STUFF("r5", Reg, 5) \
+REG_STUFF("r6", Reg, 6) \
+REG_STUFF("r7", Reg, 7) \
+REG_STUFF("r8", Reg, 8) \
+REG_STUFF("r9", Reg, 9) \
+REG_STUFF("r10", Reg, 10) \
+REG_STUFF("r11", Reg, 11) \
+REG_STUFF("r12", Reg, 12) \
+REG_STUFF("r13", Reg, 13) \
+REG_STUFF("r14", Reg, 14) \
+REG_STUFF("r15", Reg, 15) \
+REG_STUFF("lr", Reg, 14) \
+REG_STUFF("sp", Reg, 15) \
+\
+/* Special-purpose registers */ \
+REG_STUFF("pc", RegPc, -1) \
+REG_STUFF("Ira", RegIra, -1) \
+REG_STUFF("Flags", RegFlags, -1) \
+
+
+// Every register and mnemonic, in a perfect hash table that is built
+// entirely at compile time from LIST_OF_BUILTIN_REGS and
+// LIST_OF_INSTRUCTIONS.  A builtin's index in builtin_syms::entries is
+// also its SymId.
+
+namespace flare32
+{
+
+namespace builtin_syms
+{
+
+class RawInstr
+{
+public:		// variables
+	std::string_view name;
+	PInstr instr = nullptr;
+};
+
+#define INSTR_STUFF(enc_group, args, varname, value) \
+	RawInstr{value, &InstructionTable::varname##_##args##_##enc_group},
+inline constexpr RawInstr raw_instrs[]
+	= {LIST_OF_INSTRUCTIONS(INSTR_STUFF)};
+#undef INSTR_STUFF
+
+static constexpr size_t num_raw_instrs = sizeof(raw_instrs)
+	/ sizeof(raw_instrs[0]);
+
+// The most overloads that any one mnemonic has
+constexpr size_t count_max_overloads()
+{
+	size_t ret = 0;
+
+	for (const auto& outer : raw_instrs)
+	{
+		size_t count = 0;
+
+		for (const auto& inner : raw_instrs)
+		{
+			if (inner.name == outer.name)
+			{
+				++count;
+			}
+		}
+
+		ret = std::max(ret, count);
+	}
+
+	return ret;
+}
+
+static constexpr size_t max_overloads = count_max_overloads();
+
+class Entry
+{
+public:		// variables
+	std::string_view name;
+	PTok tok = nullptr;
+
+	// Register number, or -1
+	s64 value = -1;
+
+	// Mnemonics only:  every overload, in the same order as
+	// LIST_OF_INSTRUCTIONS (group 0 first)
+	std::array<PInstr, max_overloads> instrs{};
+	size_t num_instrs = 0;
+
+public:		// functions
+	constexpr const PInstr* begin() const
+	{
+		return instrs.data();
+	}
+	constexpr const PInstr* end() const
+	{
+		return instrs.data() + num_instrs;
+	}
+};
+
+#define REG_STUFF(reg_name, reg_tok, reg_value) + 1
+static constexpr size_t num_regs = 0 LIST_OF_BUILTIN_REGS(REG_STUFF);
+#undef REG_STUFF
+
+constexpr size_t count_mnemonics()
+{
+	size_t ret = 0;
+
+	for (size_t i=0; i<num_raw_instrs; ++i)
+	{
+		bool seen = false;
+
+		for (size_t j=0; j<i; ++j)
+		{
+			seen = seen || (raw_instrs[j].name == raw_instrs[i].name);
+		}
+
+		if (!seen)
+		{
+			++ret;
+		}
+	}
+
+	return ret;
+}
+
+static constexpr size_t num_entries = num_regs + count_mnemonics();
+
+constexpr std::array<Entry, num_entries> make_entries()
+{
+	std::array<Entry, num_entries> ret{};
+	size_t size = 0;
+
+	#define REG_STUFF(reg_name, reg_tok, reg_value) \
+		ret[size].name = reg_name; \
+		ret[size].tok = &Tok::reg_tok; \
+		ret[size].value = reg_value; \
+		++size;
+	LIST_OF_BUILTIN_REGS(REG_STUFF)
+	#undef REG_STUFF
+
+	for (const auto& raw_instr : raw_instrs)
+	{
+		size_t i = num_regs;
+
+		while ((i < size) && (ret[i].name != raw_instr.name))
+		{
+			++i;
+		}
+
+		if (i == size)
+		{
+			ret[size].name = raw_instr.name;
+			ret[size].tok = &Tok::Instr;
+			++size;
+		}
+
+		ret[i].instrs[ret[i].num_instrs++] = raw_instr.instr;
+	}
+
+	return ret;
+}
+
+inline constexpr std::array<Entry, num_entries> entries = make_entries();
+
+
+// The perfect hash:  a name's first hash picks a bucket, and each bucket
+// has its own seed for the second hash, which picks the slot.  The seeds
+// are searched for at compile time (biggest buckets first) so that every
+// name gets a slot to itself.
+static constexpr size_t num_buckets = 128;
+static constexpr size_t num_slots = 512;
+static_assert(num_entries <= (num_slots / 2),
+	"builtin_syms::num_slots is too small");
+
+// FNV-1a
+constexpr u32 hash_str(std::string_view some_str)
+{
+	u32 ret = 2166136261u;
+
+	for (const char c : some_str)
+	{
+		ret ^= static_cast<u8>(c);
+		ret *= 16777619u;
+	}
+
+	return ret;
+}
+
+// MurmurHash3's finalizer
+constexpr u32 mix(u32 some_hash, u32 some_seed)
+{
+	u32 ret = some_hash ^ (some_seed * 0x9e3779b9u);
+
+	ret ^= ret >> 16;
+	ret *= 0x85ebca6bu;
+	ret ^= ret >> 13;
+	ret *= 0xc2b2ae35u;
+	ret ^= ret >> 16;
+
+	return ret;
+}
+
+constexpr size_t bucket_of(u32 some_hash)
+{
+	return mix(some_hash, 0) & (num_buckets - 1);
+}
+
+constexpr size_t slot_of(u32 some_hash, u32 some_seed)
+{
+	return mix(some_hash, some_seed) & (num_slots - 1);
+}
+
+static constexpr u16 no_entry = static_cast<u16>(-1);
+static constexpr u32 max_seed = 1 << 16;
+
+class Tables
+{
+public:		// variables
+	std::array<u32, num_buckets> seeds{};
+
+	// Indices into entries
+	std::array<u16, num_slots> slots{};
+
+	bool ok = false;
+};
+
+constexpr Tables make_tables()
+{
+	Tables ret;
+
+	for (auto& slot : ret.slots)
+	{
+		slot = no_entry;
+	}
+
+	std::array<u32, num_entries> hashes{};
+	std::array<size_t, num_buckets> bucket_sizes{};
+	size_t max_bucket_size = 0;
+
+	for (size_t i=0; i<num_entries; ++i)
+	{
+		hashes[i] = hash_str(entries[i].name);
+		const size_t size = ++bucket_sizes[bucket_of(hashes[i])];
+		max_bucket_size = std::max(max_bucket_size, size);
+	}
+
+	for (size_t size=max_bucket_size; size>0; --size)
+	{
+		for (size_t bucket=0; bucket<num_buckets; ++bucket)
+		{
+			if (bucket_sizes[bucket] != size)
+			{
+				continue;
+			}
+
+			u32 seed = 0;
+
+			for (; seed<max_seed; ++seed)
+			{
+				std::array<size_t, num_entries> placed{};
+				size_t num_placed = 0;
+				bool fits = true;
+
+				for (size_t i=0; (i<num_entries) && fits; ++i)
+				{
+					if (bucket_of(hashes[i]) != bucket)
+					{
+						continue;
+					}
+
+					const size_t slot = slot_of(hashes[i], seed);
+
+					if (ret.slots[slot] != no_entry)
+					{
+						fits = false;
+					}
+
+					for (size_t j=0; j<num_placed; ++j)
+					{
+						fits = fits && (placed[j] != slot);
+					}
+
+					placed[num_placed++] = slot;
+				}
+
+				if (fits)
+				{
+					break;
+				}
+			}
+
+			if (seed == max_seed)
+			{
+				return ret;
+			}
+
+			ret.seeds[bucket] = seed;
+
+			for (size_t i=0; i<num_entries; ++i)
+			{
+				if (bucket_of(hashes[i]) == bucket)
+				{
+					ret.slots[slot_of(hashes[i], seed)] = i;
+				}
+			}
+		}
+	}
+
+	ret.ok = true;
+	return ret;
+}
+
+inline constexpr Tables tables = make_tables();
+static_assert(tables.ok, "No perfect hash for the builtin symbols");
+
+
+// Returns the index into entries (which is also the SymId), or
+// no_entry if some_name isn't a builtin
+inline size_t find(std::string_view some_name)
+{
+	const u32 some_hash = hash_str(some_name);
+	const size_t index = tables.slots[slot_of(some_hash,
+		tables.seeds[bucket_of(some_hash)])];
+
+	return ((index != no_entry) && (entries[index].name == some_name))
+		? index : no_entry;
+}
+
+// Returns nullptr if some_index isn't a builtin's
+inline const Entry* at(size_t some_index)
+{
+	return (some_index < num_entries) ? &entries[some_index] : nullptr;
+}
+
+}
+
+}
+
+
+#endif		// builtin_syms_hpp
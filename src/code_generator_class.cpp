@@ -5,30 +5,8 @@ namespace flare32
 {
 
 // Code generator stuff
-void CodeGenerator::__encode_opcode(u16& high_hword, PInstr instr) const
-{
-	//for (const auto& outer_iter : __instr_tbl.instr_vec)
-	for (size_t j=0; j<__instr_tbl->instr_vec.size(); ++j)
-	{
-		const auto& outer_iter = __instr_tbl->instr_vec.at(j);
-
-		//for (const auto& other_instr : *outer_iter)
-		for (size_t i=0; i<outer_iter->size(); ++i)
-		{
-			const auto& other_instr = outer_iter->at(i);
-			if (instr == other_instr)
-			{
-				//clear_and_set_bits_with_range(high_hword, i, 12, 8);
-				clear_and_set_bits_with_range(high_hword, i, 13, 8);
-				return;
-			}
-		}
-	}
-}
-
-
 void CodeGenerator::__encode_high_hword(u16& high_hword, 
-	const std::vector<std::string>& regs, s64 expr_result, PInstr instr)
+	const RegList& regs, s64 expr_result, PInstr instr)
 {
 	__encode_instr_group(high_hword, instr);
 	//__encode_affects_flags(high_hword, instr);
@@ -41,15 +19,13 @@ void CodeGenerator::__encode_high_hword(u16& high_hword,
 			// Encode rA
 			if (regs.size() >= 2)
 			{
-				clear_and_set_bits_with_range(high_hword, 
-					builtin_sym_tbl().at(regs.at(1)).value(), 7, 4);
+				clear_and_set_bits_with_range(high_hword, regs.at(1), 7, 4);
 			}
 
 			// Encode rB
 			if (regs.size() >= 3)
 			{
-				clear_and_set_bits_with_range(high_hword, 
-					builtin_sym_tbl().at(regs.at(2)).value(), 3, 0);
+				clear_and_set_bits_with_range(high_hword, regs.at(2), 3, 0);
 			}
 			
 			break;
@@ -58,15 +34,13 @@ void CodeGenerator::__encode_high_hword(u16& high_hword,
 			// Encode rA
 			if (regs.size() >= 1)
 			{
-				clear_and_set_bits_with_range(high_hword, 
-					builtin_sym_tbl().at(regs.at(0)).value(), 7, 4);
+				clear_and_set_bits_with_range(high_hword, regs.at(0), 7, 4);
 			}
 
 			// Encode rB
 			if (regs.size() >= 2)
 			{
-				clear_and_set_bits_with_range(high_hword, 
-					builtin_sym_tbl().at(regs.at(1)).value(), 3, 0);
+				clear_and_set_bits_with_range(high_hword, regs.at(1), 3, 0);
 			}
 			break;
 	}
@@ -75,7 +49,7 @@ void CodeGenerator::__encode_high_hword(u16& high_hword,
 
 
 void CodeGenerator::__encode_low(u16& g1g2_low, u32& g3_low, 
-	const std::vector<std::string>& regs, s64 expr_result, PInstr instr)
+	const RegList& regs, s64 expr_result, PInstr instr)
 {
 	auto handle_enc_group_2 = [&]() -> void
 	{
@@ -84,8 +58,7 @@ void CodeGenerator::__encode_low(u16& g1g2_low, u32& g3_low,
 		{
 			if (regs.size() == 3)
 			{
-				clear_and_set_bits_with_range(g1g2_low, 
-					builtin_sym_tbl().at(regs.at(2)).value(), 15, 12);
+				clear_and_set_bits_with_range(g1g2_low, regs.at(2), 15, 12);
 			}
 			else if (regs.size() > 3)
 			{
@@ -100,8 +73,7 @@ void CodeGenerator::__encode_low(u16& g1g2_low, u32& g3_low,
 		{
 			clear_and_set_bits_with_range(g1g2_low, regs.size() - 2, 1, 0);
 
-			clear_and_set_bits_with_range(g1g2_low, 
-				builtin_sym_tbl().at(regs.at(0)).value(), 7, 4);
+			clear_and_set_bits_with_range(g1g2_low, regs.at(0), 7, 4);
 
 			//if (regs.size() >= 3)
 			//{
@@ -110,13 +82,12 @@ void CodeGenerator::__encode_low(u16& g1g2_low, u32& g3_low,
 			//}
 			if (regs.size() >= 4)
 			{
-				clear_and_set_bits_with_range(g1g2_low, 
-					builtin_sym_tbl().at(regs.at(3)).value(), 15, 12);
+				clear_and_set_bits_with_range(g1g2_low, regs.at(3), 15, 12);
 			}
 			if (regs.size() >= 5)
 			{
 				clear_and_set_bits_with_range(g1g2_low,
-					builtin_sym_tbl().at(regs.at(4)).value(), 11, 8);
+					regs.at(4), 11, 8);
 			}
 
 			if ((regs.size() < 2) || (regs.size() > 5))
@@ -152,8 +123,7 @@ void CodeGenerator::__encode_low(u16& g1g2_low, u32& g3_low,
 		{
 			clear_and_set_bits_with_range(g3_low, regs.size() - 6, 1, 0);
 
-			clear_and_set_bits_with_range(g3_low, 
-				builtin_sym_tbl().at(regs.at(0)).value(), 7, 4);
+			clear_and_set_bits_with_range(g3_low, regs.at(0), 7, 4);
 
 			//if (regs.size() >= 3)
 			//{
@@ -163,33 +133,32 @@ void CodeGenerator::__encode_low(u16& g1g2_low, u32& g3_low,
 
 			//if (regs.size() >= 4)
 			{
-				clear_and_set_bits_with_range(g3_low, 
-					builtin_sym_tbl().at(regs.at(3)).value(), 31, 28);
+				clear_and_set_bits_with_range(g3_low, regs.at(3), 31, 28);
 			}
 			//if (regs.size() >= 5)
 			{
 				clear_and_set_bits_with_range(g3_low,
-					builtin_sym_tbl().at(regs.at(4)).value(), 27, 24);
+					regs.at(4), 27, 24);
 			}
 			if (regs.size() >= 6)
 			{
 				clear_and_set_bits_with_range(g3_low,
-					builtin_sym_tbl().at(regs.at(5)).value(), 23, 20);
+					regs.at(5), 23, 20);
 			}
 			if (regs.size() >= 7)
 			{
 				clear_and_set_bits_with_range(g3_low,
-					builtin_sym_tbl().at(regs.at(6)).value(), 19, 16);
+					regs.at(6), 19, 16);
 			}
 			if (regs.size() >= 8)
 			{
 				clear_and_set_bits_with_range(g3_low,
-					builtin_sym_tbl().at(regs.at(7)).value(), 15, 12);
+					regs.at(7), 15, 12);
 			}
 			if (regs.size() >= 9)
 			{
 				clear_and_set_bits_with_range(g3_low,
-					builtin_sym_tbl().at(regs.at(8)).value(), 11, 8);
+					regs.at(8), 11, 8);
 			}
 
 			//clear_and_set_bits_with_range(g3_low,
@@ -205,33 +174,32 @@ void CodeGenerator::__encode_low(u16& g1g2_low, u32& g3_low,
 		{
 			if (regs.size() >= 3)
 			{
-				clear_and_set_bits_with_range(g3_low, 
-					builtin_sym_tbl().at(regs.at(2)).value(), 31, 28);
+				clear_and_set_bits_with_range(g3_low, regs.at(2), 31, 28);
 			}
 			if (regs.size() >= 4)
 			{
 				clear_and_set_bits_with_range(g3_low,
-					builtin_sym_tbl().at(regs.at(3)).value(), 27, 24);
+					regs.at(3), 27, 24);
 			}
 			if (regs.size() >= 5)
 			{
 				clear_and_set_bits_with_range(g3_low,
-					builtin_sym_tbl().at(regs.at(4)).value(), 23, 20);
+					regs.at(4), 23, 20);
 			}
 			if (regs.size() >= 6)
 			{
 				clear_and_set_bits_with_range(g3_low,
-					builtin_sym_tbl().at(regs.at(5)).value(), 19, 16);
+					regs.at(5), 19, 16);
 			}
 			if (regs.size() >= 7)
 			{
 				clear_and_set_bits_with_range(g3_low,
-					builtin_sym_tbl().at(regs.at(6)).value(), 15, 12);
+					regs.at(6), 15, 12);
 			}
 			if (regs.size() >= 8)
 			{
 				clear_and_set_bits_with_range(g3_low,
-					builtin_sym_tbl().at(regs.at(7)).value(), 11, 8);
+					regs.at(7), 11, 8);
 			}
 		}
 
@@ -257,7 +225,7 @@ void CodeGenerator::__encode_low(u16& g1g2_low, u32& g3_low,
 }
 
 void CodeGenerator::encode_and_gen
-	(const std::vector<std::string>& regs, s64 expr_result, 
+	(const RegList& regs, s64 expr_result, 
 	PInstr instr)
 {
 	u16 high_hword = 0;
@@ -269,11 +237,12 @@ void CodeGenerator::encode_and_gen
 	gen16(high_hword);
 	__gen_low(g1g2_low, g3_low, instr);
 
-	if (can_output())
-	{
-		printout("\n");
-	}
+	end_item();
+}
 
+void CodeGenerator::skip_instr(PInstr instr)
+{
+	set_last_addr(set_addr(addr() + instr->size()));
 }
 
 void CodeGenerator::__gen_low(u16 g1g2_low, u32 g3_low, PInstr instr) 
@@ -302,11 +271,7 @@ void CodeGenerator::gen8(s32 v)
 {
 	if (can_output())
 	{
-		if (last_addr() != addr())
-		{
-			printf("@%08x\n", static_cast<u32>(addr()));
-		}
-		printf("%02x\n", (static_cast<u32>(v) & 0xff));
+		output_buf().gen8(addr(), v);
 	}
 
 	set_last_addr(set_addr(addr() + 1));
@@ -324,5 +289,13 @@ void CodeGenerator::gen32(s32 v)
 	gen8(v);
 }
 
+void CodeGenerator::end_item()
+{
+	if (can_output())
+	{
+		output_buf().end_item();
+	}
+}
+
 
 }
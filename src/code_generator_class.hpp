@@ -10,6 +10,8 @@
 #include "parse_node_class.hpp"
 #include "warn_error_class.hpp"
 #include "options_class.hpp"
+#include "output_buffer_class.hpp"
+#include "reg_list_class.hpp"
 
 namespace flare32
 {
@@ -20,24 +22,25 @@ private:		// variables
 	WarnError* __we = nullptr;
 	size_t * __addr = nullptr, * __last_addr = nullptr;
 	s32* __pass = nullptr;
-	s32 last_pass;
-	SymbolTable * __builtin_sym_tbl = nullptr, * __user_sym_tbl = nullptr;
+	s32 first_output_pass;
+	SymbolTable* __user_sym_tbl = nullptr;
 	DefineTable* __define_tbl = nullptr;
 	InstructionTable* __instr_tbl = nullptr;
 	Options* __options = nullptr;
+	OutputBuffer* __output_buf = nullptr;
 
 
 public:		// functions
 	inline CodeGenerator(WarnError* s_we, size_t* s_addr,
-		size_t* s_last_addr, s32* s_pass, s32 s_last_pass,
-		SymbolTable* s_builtin_sym_tbl, SymbolTable* s_user_sym_tbl,
-		DefineTable* s_define_tbl, InstructionTable* s_instr_tbl,
-		Options* s_options)
+		size_t* s_last_addr, s32* s_pass, s32 s_first_output_pass,
+		SymbolTable* s_user_sym_tbl, DefineTable* s_define_tbl,
+		InstructionTable* s_instr_tbl,
+		Options* s_options, OutputBuffer* s_output_buf)
 		: __we(s_we), __addr(s_addr), __last_addr(s_last_addr),
-		__pass(s_pass), last_pass(s_last_pass),
-		__builtin_sym_tbl(s_builtin_sym_tbl),
+		__pass(s_pass), first_output_pass(s_first_output_pass),
 		__user_sym_tbl(s_user_sym_tbl), __define_tbl(s_define_tbl),
-		__instr_tbl(s_instr_tbl), __options(s_options)
+		__instr_tbl(s_instr_tbl), __options(s_options),
+		__output_buf(s_output_buf)
 	{
 	}
 
@@ -56,21 +59,30 @@ public:		// functions
 	//	clear_and_set_bits_with_range(high_hword, instr->affects_flags(),
 	//		13, 13);
 	//}
-	void __encode_opcode(u16& high_hword, PInstr instr) const;
+	inline void __encode_opcode(u16& high_hword, PInstr instr) const
+	{
+		clear_and_set_bits_with_range(high_hword, instr->opcode(), 13, 8);
+	}
 	void __encode_high_hword(u16& high_hword, 
-		const std::vector<std::string>& regs, s64 expr_result,
+		const RegList& regs, s64 expr_result,
 		PInstr instr);
 	void __encode_low(u16& g1g2_low, u32& g3_low, 
-		const std::vector<std::string>& regs, s64 expr_result,
+		const RegList& regs, s64 expr_result,
 		PInstr instr);
 	void __gen_low(u16 g1g2_low, u32 g3_low, PInstr instr);
-	void encode_and_gen(const std::vector<std::string>& regs, 
+	void encode_and_gen(const RegList& regs, 
 		s64 expr_result, PInstr instr);
 
+	// Advance past instr without encoding it
+	void skip_instr(PInstr instr);
+
 	void gen8(s32 v);
 	void gen16(s32 v);
 	void gen32(s32 v);
 
+	// Marks the end of one instruction or .db/.dw value
+	void end_item();
+
 private:		// functions
 
 	inline auto& we() const
@@ -104,11 +116,6 @@ private:		// functions
 		return *__pass;
 	}
 
-	inline auto& builtin_sym_tbl() const
-	{
-		return *__builtin_sym_tbl;
-	}
-
 	inline auto& user_sym_tbl() const
 	{
 		return *__user_sym_tbl;
@@ -129,9 +136,14 @@ private:		// functions
 		return *__options;
 	}
 
+	inline auto& output_buf() const
+	{
+		return *__output_buf;
+	}
+
 	inline bool can_output() const
 	{
-		return (pass() == last_pass);
+		return (pass() >= first_output_pass);
 	}
 
 
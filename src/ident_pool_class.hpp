@@ -0,0 +1,114 @@
+#ifndef ident_pool_class_hpp
+#define ident_pool_class_hpp
+
+
+#include "misc_includes.hpp"
+
+#include "user_ident_table_class.hpp"
+#include "builtin_syms.hpp"
+
+namespace flare32
+{
+
+// Symbol IDs are handed out by an IdentPool
+typedef u32 SymId;
+
+class IdentPool
+{
+public:		// constants
+	static constexpr SymId bad_id = static_cast<SymId>(-1);
+
+private:		// classes
+	class Ident
+	{
+	private:		// variables
+		std::string __name;
+		SymId __id = bad_id;
+
+	public:		// functions
+		inline Ident()
+		{
+		}
+		inline Ident(std::string_view s_name, SymId s_id)
+			: __name(s_name), __id(s_id)
+		{
+		}
+
+		inline Ident(const Ident& to_copy) = default;
+		inline Ident(Ident&& to_move) = default;
+
+		inline Ident& operator = (const Ident& to_copy) = default;
+		inline Ident& operator = (Ident&& to_move) = default;
+
+		gen_getter_by_con_ref(name)
+		gen_getter_by_val(id)
+	};
+
+private:		// variables
+	// Builtins (registers and mnemonics) always have their index into
+	// builtin_syms::entries as their ID, and are never put in __table.
+	// Everything else has builtin_syms::num_entries plus its index into
+	// __table.entries().
+	UserIdentTable<Ident> __table;
+
+public:		// functions
+	inline IdentPool()
+	{
+	}
+
+	// Returns the ID of some_name, giving it a new one if it doesn't
+	// already have one
+	inline SymId intern(std::string_view some_name)
+	{
+		const size_t builtin_index = builtin_syms::find(some_name);
+
+		if (builtin_index != builtin_syms::no_entry)
+		{
+			return builtin_index;
+		}
+
+		if (const Ident* ident = __table.find(some_name))
+		{
+			return ident->id();
+		}
+
+		const SymId ret = size();
+		__table.insert_or_assign(Ident(some_name, ret));
+		return ret;
+	}
+
+	// Returns bad_id if some_name has never been interned (builtins
+	// always have been)
+	inline SymId find(std::string_view some_name) const
+	{
+		const size_t builtin_index = builtin_syms::find(some_name);
+
+		if (builtin_index != builtin_syms::no_entry)
+		{
+			return builtin_index;
+		}
+
+		const Ident* ident = __table.find(some_name);
+		return (ident != nullptr) ? ident->id() : bad_id;
+	}
+
+	inline std::string_view str(SymId some_id) const
+	{
+		if (some_id < builtin_syms::num_entries)
+		{
+			return builtin_syms::entries[some_id].name;
+		}
+		return __table.entries().at(some_id - builtin_syms::num_entries)
+			.name();
+	}
+
+	inline size_t size() const
+	{
+		return builtin_syms::num_entries + __table.entries().size();
+	}
+};
+
+}
+
+
+#endif		// ident_pool_class_hpp
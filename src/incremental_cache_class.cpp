@@ -0,0 +1,205 @@
+#include "incremental_cache_class.hpp"
+
+namespace flare32
+{
+
+void IncrementalCache::add_line(u64 some_hash, bool some_reusable,
+	size_t some_addr, const std::vector<u8>& some_data,
+	const std::vector<u32>& some_item_ends)
+{
+	Line line;
+	line.hash = some_hash;
+	line.reusable = some_reusable;
+	line.addr = some_addr;
+	line.size = some_data.size();
+	line.first_data = data.size();
+	line.first_item_end = item_ends.size();
+	line.num_item_ends = some_item_ends.size();
+
+	data.insert(data.end(), some_data.begin(), some_data.end());
+	item_ends.insert(item_ends.end(), some_item_ends.begin(),
+		some_item_ends.end());
+	lines.push_back(line);
+}
+
+bool IncrementalCache::write(const std::string& some_filename) const
+{
+	std::string file_data = magic;
+	append_u32(file_data, version);
+	append_u8(file_data, found_redefinition);
+
+	append_u32(file_data, lines.size());
+
+	for (const auto& line : lines)
+	{
+		append_u64(file_data, line.hash);
+		append_u8(file_data, line.reusable);
+		append_u32(file_data, line.addr);
+		append_u32(file_data, line.size);
+
+		append_u32(file_data, line.num_item_ends);
+
+		for (size_t i=0; i<line.num_item_ends; ++i)
+		{
+			append_u32(file_data, item_ends[line.first_item_end + i]);
+		}
+
+		file_data.append(data.begin() + line.first_data,
+			data.begin() + line.first_data + line.size);
+	}
+
+	append_u32(file_data, syms.size());
+
+	for (const auto& sym : syms)
+	{
+		append_u64(file_data, sym.second);
+		append_u32(file_data, sym.first.size());
+		file_data += sym.first;
+	}
+
+	// Write to a temporary file first, so that there's never a partly
+	// written cache file around
+	const std::string temp_filename = some_filename + ".tmp";
+	FILE* outfile = fopen(temp_filename.c_str(), "wb");
+
+	if (outfile == nullptr)
+	{
+		return false;
+	}
+
+	const bool ok = (fwrite(file_data.data(), 1, file_data.size(), outfile)
+		== file_data.size());
+
+	if ((fclose(outfile) != 0) || !ok
+		|| (std::rename(temp_filename.c_str(), some_filename.c_str()) != 0))
+	{
+		std::remove(temp_filename.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+bool IncrementalCache::read(const std::string& some_filename)
+{
+	clear();
+
+	FILE* infile = fopen(some_filename.c_str(), "rb");
+
+	if (infile == nullptr)
+	{
+		return false;
+	}
+
+	std::string file_data;
+	read_whole_file(infile, file_data);
+	fclose(infile);
+
+	BinaryReader reader(file_data);
+	std::string_view bytes;
+
+	auto fail = [&]() -> bool
+	{
+		clear();
+		return false;
+	};
+
+	if (!reader.read_bytes(sizeof(magic) - 1, bytes) || (bytes != magic)
+		|| (reader.read_u32() != version))
+	{
+		return fail();
+	}
+
+	found_redefinition = reader.read_u8();
+
+	for (u32 i=reader.read_u32(); (i>0) && reader.ok(); --i)
+	{
+		const u64 hash = reader.read_u64();
+		const bool reusable = reader.read_u8();
+		const size_t addr = reader.read_u32();
+		const size_t size = reader.read_u32();
+		const size_t num_item_ends = reader.read_u32();
+
+		if (num_item_ends > file_data.size())
+		{
+			return fail();
+		}
+
+		std::vector<u32> line_item_ends(num_item_ends);
+
+		for (auto& item_end : line_item_ends)
+		{
+			item_end = reader.read_u32();
+
+			if (item_end > size)
+			{
+				return fail();
+			}
+		}
+
+		if (!reader.read_bytes(size, bytes))
+		{
+			return fail();
+		}
+
+		add_line(hash, reusable, addr, std::vector<u8>(bytes.begin(),
+			bytes.end()), line_item_ends);
+	}
+
+	for (u32 i=reader.read_u32(); (i>0) && reader.ok(); --i)
+	{
+		const s64 value = reader.read_u64();
+
+		if (!reader.read_bytes(reader.read_u32(), bytes))
+		{
+			return fail();
+		}
+
+		syms.push_back(std::pair<std::string, s64>(bytes, value));
+	}
+
+	if (!reader.ok() || !reader.at_end())
+	{
+		return fail();
+	}
+
+	return true;
+}
+
+u64 IncrementalCache::hash_line(ParseSpan some_parse_vec,
+	const IdentPool& some_ident_pool)
+{
+	// FNV-1a
+	u64 ret = 14695981039346656037ull;
+
+	auto hash_byte = [&](u8 some_byte) -> void
+	{
+		ret ^= some_byte;
+		ret *= 1099511628211ull;
+	};
+
+	for (const auto& node : some_parse_vec)
+	{
+		hash_byte(static_cast<u8>(node.next_tok_kind));
+
+		for (size_t i=0; i<sizeof(node.next_num); ++i)
+		{
+			hash_byte(static_cast<u64>(node.next_num) >> (i * 8));
+		}
+
+		if (node.next_sym_id != IdentPool::bad_id)
+		{
+			for (const char c : some_ident_pool.str(node.next_sym_id))
+			{
+				hash_byte(c);
+			}
+		}
+
+		// So that "ab" "c" and "a" "bc" are different
+		hash_byte(0);
+	}
+
+	return ret;
+}
+
+}
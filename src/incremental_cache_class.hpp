@@ -0,0 +1,95 @@
+#ifndef incremental_cache_class_hpp
+#define incremental_cache_class_hpp
+
+#include "misc_includes.hpp"
+#include "parse_node_class.hpp"
+#include "binary_file_funcs.hpp"
+
+namespace flare32
+{
+
+// What the -i option remembers about the last time a file was assembled,
+// so that lines that haven't changed don't need to be assembled again.
+// It's kept next to the input file, as input_file.icache:
+//
+//	"F32I", u32 version, u8 found_redefinition
+//	u32 num_lines, then for each one:
+//		u64 hash, u8 reusable, u32 addr, u32 size,
+//		u32 num_item_ends, u32 item_ends[num_item_ends], u8 data[size]
+//	u32 num_syms, then for each one:
+//		u64 value, u32 name_size, char name[name_size]
+class IncrementalCache
+{
+public:		// classes
+	// One of the assembler's __lexed_lines
+	class Line
+	{
+	public:		// variables
+		// Of the line's tokens (see hash_line())
+		u64 hash = 0;
+
+		// Whether data and item_ends are everything the line generated
+		bool reusable = false;
+
+		// Where the line started, and how many bytes it generated
+		size_t addr = 0, size = 0;
+
+		// Indices into IncrementalCache::data and ::item_ends
+		size_t first_data = 0;
+		size_t first_item_end = 0, num_item_ends = 0;
+	};
+
+private:		// constants
+	static constexpr char magic[] = "F32I";
+
+	// Change this whenever the same tokens could get encoded differently
+	static constexpr u32 version = 1;
+
+public:		// variables
+	std::vector<Line> lines;
+
+	// Every line's bytes, back to back
+	std::vector<u8> data;
+
+	// Offsets into each line's bytes at which an item ends
+	std::vector<u32> item_ends;
+
+	// Every label's and equate's value at the end of the output pass
+	std::vector<std::pair<std::string, s64>> syms;
+
+	// Whether any label or equate was defined more than once, in which
+	// case a symbol's value at the end isn't necessarily its value where
+	// it was used
+	bool found_redefinition = false;
+
+public:		// functions
+	inline IncrementalCache()
+	{
+	}
+
+	inline void clear()
+	{
+		*this = IncrementalCache();
+	}
+
+	// Adds a line that generated some_data
+	void add_line(u64 some_hash, bool some_reusable, size_t some_addr,
+		const std::vector<u8>& some_data,
+		const std::vector<u32>& some_item_ends);
+
+	// Returns false if the file can't be written
+	bool write(const std::string& some_filename) const;
+
+	// Returns false (and clear()s) if there's no valid cache file
+	bool read(const std::string& some_filename);
+
+	// A hash of some_parse_vec's tokens, which (unlike their SymIds)
+	// doesn't depend on what order identifiers were first seen in
+	static u64 hash_line(ParseSpan some_parse_vec,
+		const IdentPool& some_ident_pool);
+};
+
+}
+
+
+#endif		// incremental_cache_class_hpp
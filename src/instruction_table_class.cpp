@@ -5,7 +5,9 @@ namespace flare32
 
 #define INSTR_STUFF(enc_group, args, varname, value) \
 InstructionTable::varname##_##args##_##enc_group(value, 0, \
-	InstrArgs::args, enc_group),
+	InstrArgs::args, enc_group, \
+	static_cast<s32>(InstrG##enc_group##Opcode \
+	::varname##_##args##_##enc_group)),
 
 
 
@@ -16,77 +18,103 @@ const Instruction
 #undef INSTR_STUFF
 
 
-#define INSTR_STUFF(enc_group, args, varname, value) \
-	&InstructionTable::varname##_##args##_##enc_group,
-
-const std::vector<PInstr> InstructionTable::instr_g0_vec
-({
-	LIST_OF_GROUP_0_INSTRUCTIONS(INSTR_STUFF)
-
-});
-
-const std::vector<PInstr> InstructionTable::instr_g1_vec
-({
-	LIST_OF_GROUP_1_INSTRUCTIONS(INSTR_STUFF)
-
-});
-
-
-const std::vector<PInstr> InstructionTable::instr_g2_vec
-({
-	LIST_OF_GROUP_2_INSTRUCTIONS(INSTR_STUFF)
-
-});
-
-const std::vector<PInstr> InstructionTable::instr_g3_vec
-({
-	LIST_OF_GROUP_3_INSTRUCTIONS(INSTR_STUFF)
-
-});
-
-
-
-#undef INSTR_STUFF
-
-const std::vector<const std::vector<PInstr>*> InstructionTable::instr_vec
-({
-	&InstructionTable::instr_g0_vec,
-	&InstructionTable::instr_g1_vec,
-	&InstructionTable::instr_g2_vec,
-	&InstructionTable::instr_g3_vec
-});
-
-InstructionTable::InstructionTable()
+bool InstructionTable::args_match_signature(InstrArgs some_args, 
+	std::string_view some_signature)
 {
-	std::set<std::string> instr_names;
+	auto exactly = [&](std::string_view to_cmp) -> bool
+	{
+		return (some_signature == to_cmp);
+	};
 
-	for (const auto& outer_iter : instr_vec)
+	// An expression comes after the prefix
+	auto prefix_then_expr = [&](std::string_view prefix) -> bool
 	{
-		for (const auto& instr : *outer_iter)
-		{
-			instr_names.insert(instr->str());
-		}
-	}
+		return ((some_signature.size() > prefix.size())
+			&& (some_signature.substr(0, prefix.size()) == prefix));
+	};
 
-	for (const auto& name : instr_names)
+	// An expression comes after the prefix, followed by a "]"
+	auto prefix_then_expr_then_rbracket = [&](std::string_view prefix)
+		-> bool
 	{
-		std::vector<PInstr> to_insert;
-
-		for (const auto& outer_iter : instr_vec)
-		{
-			for (const auto& instr : *outer_iter)
-			{
-				if (instr->str() == name)
-				{
-					to_insert.push_back(instr);
-				}
-			}
-		}
-
-		__table[name] = std::move(to_insert);
-	}
+		return ((some_signature.size() >= (prefix.size() + 2))
+			&& (some_signature.substr(0, prefix.size()) == prefix)
+			&& (some_signature.back() == ']'));
+	};
 
+	switch (some_args)
+	{
+		case InstrArgs::NoArgs:
+			return exactly("");
+		case InstrArgs::UImm16:
+		case InstrArgs::SImm16:
+		case InstrArgs::Imm32:
+		case InstrArgs::Branch:
+			return prefix_then_expr("");
+
+		case InstrArgs::Ra:
+			return exactly("r");
+		case InstrArgs::RaUImm16:
+			return prefix_then_expr("r,");
+		case InstrArgs::RaRb:
+			return exactly("r,r");
+		case InstrArgs::RaRbUImm16:
+		case InstrArgs::RaRbSImm16:
+		case InstrArgs::RaRbImm32:
+			return prefix_then_expr("r,r,");
+		case InstrArgs::RaRbRc:
+			return exactly("r,r,r");
+		case InstrArgs::RaRbRcSImm12:
+			return prefix_then_expr("r,r,r,");
+
+		case InstrArgs::LdStRaRb:
+			return exactly("r,[r]");
+		case InstrArgs::LdStRaRbRcSImm12:
+			return prefix_then_expr_then_rbracket("r,[r,r,");
+		case InstrArgs::LdStRaRbRc:
+			return exactly("r,[r,r]");
+		case InstrArgs::LdStRaRbSImm12:
+		case InstrArgs::LdStRaRbImm32:
+			return prefix_then_expr_then_rbracket("r,[r,");
+
+		// Block moves (ldmia, stmia, stmdb) with number of {} args
+		case InstrArgs::LdStBlock1To4:
+			return (exactly("r,{r}") || exactly("r,{r,r}")
+				|| exactly("r,{r,r,r}") || exactly("r,{r,r,r,r}"));
+		case InstrArgs::LdStBlock5To8:
+			return (exactly("r,{r,r,r,r,r}") 
+				|| exactly("r,{r,r,r,r,r,r}")
+				|| exactly("r,{r,r,r,r,r,r,r}") 
+				|| exactly("r,{r,r,r,r,r,r,r,r}"));
+
+		case InstrArgs::Ira:
+			return exactly("i");
+		case InstrArgs::RaIra:
+			return exactly("r,i");
+		case InstrArgs::IraRa:
+			return exactly("i,r");
+
+		case InstrArgs::RaFlags:
+			return exactly("r,f");
+		case InstrArgs::Flags:
+			return exactly("f");
+		case InstrArgs::FlagsRa:
+			return exactly("f,r");
+
+		case InstrArgs::RaPc:
+			return exactly("r,p");
+
+		case InstrArgs::LongMul:
+			return exactly("r:r,r,r");
+		case InstrArgs::LongDivMod:
+			return exactly("r:r,r:r,r:r,r:r");
+		case InstrArgs::DivMod:
+			return exactly("r,r,r,r");
+		case InstrArgs::LongBitShift:
+			return exactly("r:r,r:r,r:r");
+	}
 
+	return false;
 }
 
 }
@@ -109,6 +109,45 @@ enum class InstrArgs
 
 
 
+// An instruction's opcode is its position within its encoding group, so
+// these are generated from the same lists as everything else.
+#define INSTR_STUFF(enc_group, args, varname, value) \
+	varname##_##args##_##enc_group,
+
+enum class InstrG0Opcode : s32
+{
+	LIST_OF_GROUP_0_INSTRUCTIONS(INSTR_STUFF)
+	Lim,
+};
+enum class InstrG1Opcode : s32
+{
+	LIST_OF_GROUP_1_INSTRUCTIONS(INSTR_STUFF)
+	Lim,
+};
+enum class InstrG2Opcode : s32
+{
+	LIST_OF_GROUP_2_INSTRUCTIONS(INSTR_STUFF)
+	Lim,
+};
+enum class InstrG3Opcode : s32
+{
+	LIST_OF_GROUP_3_INSTRUCTIONS(INSTR_STUFF)
+	Lim,
+};
+
+#undef INSTR_STUFF
+
+// Opcodes are encoded in 6 bits
+static_assert(static_cast<s32>(InstrG0Opcode::Lim) <= 64,
+	"Too many group 0 instructions");
+static_assert(static_cast<s32>(InstrG1Opcode::Lim) <= 64,
+	"Too many group 1 instructions");
+static_assert(static_cast<s32>(InstrG2Opcode::Lim) <= 64,
+	"Too many group 2 instructions");
+static_assert(static_cast<s32>(InstrG3Opcode::Lim) <= 64,
+	"Too many group 3 instructions");
+
+
 class Instruction;
 typedef const Instruction* PInstr;
 
@@ -119,22 +158,24 @@ private:		// variables
 	bool __affects_flags;
 	InstrArgs __args;
 	s32 __enc_group;
+	s32 __opcode;
 
 
 public:		// constants
-	inline Instruction() : Instruction("", 0, InstrArgs::NoArgs, -1)
+	inline Instruction() : Instruction("", 0, InstrArgs::NoArgs, -1, -1)
 	{
 	}
 	inline Instruction(const std::string& s_str, bool s_affects_flags,
-		InstrArgs s_args, s32 s_enc_group) : __str(s_str), 
+		InstrArgs s_args, s32 s_enc_group, s32 s_opcode) : __str(s_str), 
 		__affects_flags(s_affects_flags), __args(s_args),
-		__enc_group(s_enc_group)
+		__enc_group(s_enc_group), __opcode(s_opcode)
 	{
 	}
 	inline Instruction(std::string&& s_str, bool s_affects_flags,
-		InstrArgs s_args, s32 s_enc_group) : __str(std::move(s_str)), 
+		InstrArgs s_args, s32 s_enc_group, s32 s_opcode)
+		: __str(std::move(s_str)), 
 		__affects_flags(s_affects_flags), __args(s_args),
-		__enc_group(s_enc_group)
+		__enc_group(s_enc_group), __opcode(s_opcode)
 	{
 	}
 
@@ -148,14 +189,29 @@ public:		// constants
 	gen_getter_by_val(affects_flags)
 	gen_getter_by_val(args)
 	gen_getter_by_val(enc_group)
+	gen_getter_by_val(opcode)
+
+	// Size in bytes, which only depends on the encoding group
+	inline size_t size() const
+	{
+		switch (enc_group())
+		{
+			case 0:
+				return 2;
+			case 1:
+			case 2:
+				return 4;
+			default:
+				return 6;
+		}
+	}
 
 };
 
+// Each mnemonic's overloads are found through builtin_syms (see
+// builtin_syms.hpp), which is generated from the same lists.
 class InstructionTable
 {
-private:		// variables
-	std::map<std::string, std::vector<PInstr>> __table;
-
 public:		// static constant variables
 	#define INSTR_STUFF(enc_group, args, varname, value) \
 	varname##_##args##_##enc_group,
@@ -167,24 +223,21 @@ public:		// static constant variables
 
 	#undef INSTR_STUFF
 
-	static const std::vector<PInstr> instr_g0_vec, instr_g1_vec,
-		instr_g2_vec, instr_g3_vec;
-
-	static const std::vector<const std::vector<PInstr>*> instr_vec;
-
 public:		// functions
-	InstructionTable();
-
-	inline const std::vector<PInstr>& at
-		(const std::string& some_name) const
+	inline InstructionTable()
 	{
-		return __table.at(some_name);
 	}
 
-	inline bool contains(const std::string& some_name) const
-	{
-		return (__table.count(some_name) == 1);
-	}
+	// An operand signature has one character per token after the
+	// mnemonic:  'r' for a general-purpose register, 'i' for Ira, 'f' for
+	// Flags, 'p' for pc, the punctuation itself for ",", ":", "[", "]",
+	// "{", and "}", and 'e' for anything else.  A run of several 'e's is
+	// collapsed into one, since that's always (part of) an expression.
+	// 
+	// For example, "ldr r1, [r2, r3, some_label + 4]" has the signature
+	// "r,[r,r,e]".
+	static bool args_match_signature(InstrArgs some_args, 
+		std::string_view some_signature);
 
 
 };
@@ -0,0 +1,395 @@
+#ifndef lex_tables_hpp
+#define lex_tables_hpp
+
+#include "misc_includes.hpp"
+#include "tokens_and_stuff.hpp"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Lookup tables (and the scanning helpers built on them) for the lexer,
+// built at compile time from the same
+// LIST_OF_*_TOKENS lists that Tok itself is built from, so that they can't
+// get out of sync with each other.
+
+namespace flare32
+{
+
+namespace lex_tables
+{
+
+// Character classes (bits)
+static constexpr u8 cc_space = 1 << 0;		// Whitespace other than '\n'
+static constexpr u8 cc_digit = 1 << 1;
+static constexpr u8 cc_ident_start = 1 << 2;	// Letters, '_', '`'
+static constexpr u8 cc_ident = 1 << 3;		// Letters, digits, '_'
+static constexpr u8 cc_xdigit = 1 << 4;		// Hexadecimal digits
+static constexpr u8 cc_bdigit = 1 << 5;		// '0', '1'
+
+constexpr std::array<u8, 256> make_char_classes()
+{
+	std::array<u8, 256> ret{};
+
+	for (const char c : {' ', '\t', '\v', '\f', '\r'})
+	{
+		ret[static_cast<u8>(c)] |= cc_space;
+	}
+
+	for (char c='0'; c<='9'; ++c)
+	{
+		ret[static_cast<u8>(c)] |= cc_digit | cc_ident | cc_xdigit;
+	}
+
+	for (char c='a'; c<='f'; ++c)
+	{
+		ret[static_cast<u8>(c)] |= cc_xdigit;
+		ret[static_cast<u8>(c - 'a' + 'A')] |= cc_xdigit;
+	}
+
+	for (char c='a'; c<='z'; ++c)
+	{
+		ret[static_cast<u8>(c)] |= cc_ident_start | cc_ident;
+		ret[static_cast<u8>(c - 'a' + 'A')] |= cc_ident_start | cc_ident;
+	}
+
+	ret[static_cast<u8>('0')] |= cc_bdigit;
+	ret[static_cast<u8>('1')] |= cc_bdigit;
+
+	ret[static_cast<u8>('_')] |= cc_ident_start | cc_ident;
+	ret[static_cast<u8>('`')] |= cc_ident_start;
+
+	return ret;
+}
+
+inline constexpr std::array<u8, 256> char_classes = make_char_classes();
+
+// some_char can be EOF
+inline u8 char_class(int some_char)
+{
+	return (some_char == EOF) ? 0
+		: char_classes[static_cast<u8>(some_char)];
+}
+
+// Returns the index of the first character at or after some_index that
+// isn't cc_space, or some_line.size() if there isn't one.  Indentation and
+// alignment padding tend to come in long runs, so this checks 16
+// characters at a time where it can.
+inline size_t skip_spaces(std::string_view some_line, size_t some_index)
+{
+	#if defined(__SSE2__)
+	const __m128i space = _mm_set1_epi8(' '), tab = _mm_set1_epi8('\t'),
+		vtab = _mm_set1_epi8('\v'), form_feed = _mm_set1_epi8('\f'),
+		carriage_ret = _mm_set1_epi8('\r');
+
+	while ((some_index + 16) <= some_line.size())
+	{
+		const __m128i chunk = _mm_loadu_si128
+			(reinterpret_cast<const __m128i*>(some_line.data()
+			+ some_index));
+		const __m128i is_space = _mm_or_si128(_mm_or_si128
+			(_mm_or_si128(_mm_cmpeq_epi8(chunk, space),
+			_mm_cmpeq_epi8(chunk, tab)),
+			_mm_or_si128(_mm_cmpeq_epi8(chunk, vtab),
+			_mm_cmpeq_epi8(chunk, form_feed))),
+			_mm_cmpeq_epi8(chunk, carriage_ret));
+		const u32 not_space_mask = (~static_cast<u32>(_mm_movemask_epi8
+			(is_space))) & 0xffff;
+
+		if (not_space_mask != 0)
+		{
+			return some_index + __builtin_ctz(not_space_mask);
+		}
+
+		some_index += 16;
+	}
+	#endif		// defined(__SSE2__)
+
+	while ((some_index < some_line.size())
+		&& (char_class(some_line[some_index]) & cc_space))
+	{
+		++some_index;
+	}
+
+	return some_index;
+}
+
+
+// Returns the index of the first character at or after some_index that
+// isn't in some_class, or some_line.size() if there isn't one
+inline size_t skip_class(std::string_view some_line, size_t some_index,
+	u8 some_class)
+{
+	while ((some_index < some_line.size())
+		&& (char_class(some_line[some_index]) & some_class))
+	{
+		++some_index;
+	}
+
+	return some_index;
+}
+
+
+// Numeric literals are converted eight digits at a time:  the digits are
+// loaded into one u64 (first digit in the low byte) and combined with a
+// few shifts and multiplies instead of one multiply-add per digit.
+inline u64 load_eight_chars(const char* some_chars)
+{
+	u64 ret;
+	memcpy(&ret, some_chars, sizeof(ret));
+
+	#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+	ret = __builtin_bswap64(ret);
+	#endif
+
+	return ret;
+}
+
+inline u32 eight_dec_digits(const char* some_chars)
+{
+	u64 ret = load_eight_chars(some_chars);
+
+	ret = ((ret & 0x0f0f0f0f0f0f0f0full) * ((10 << 8) + 1)) >> 8;
+	ret = ((ret & 0x00ff00ff00ff00ffull) * ((100 << 16) + 1)) >> 16;
+	ret = ((ret & 0x0000ffff0000ffffull) * ((10000ull << 32) + 1)) >> 32;
+
+	return ret;
+}
+
+inline u32 eight_hex_digits(const char* some_chars)
+{
+	u64 ret = load_eight_chars(some_chars);
+
+	// '0'..'9' are 0x3_, and 'a'..'f' and 'A'..'F' are 0x41..0x46 and
+	// 0x61..0x66, so letters just need 9 added to their low nibble.
+	ret = (ret & 0x0f0f0f0f0f0f0f0full)
+		+ (((ret & 0x4040404040404040ull) >> 6) * 9);
+
+	// Combine neighbouring nibbles, then bytes, then halfwords
+	ret = ((ret << 4) | (ret >> 8)) & 0x00ff00ff00ff00ffull;
+	ret = ((ret << 8) | (ret >> 16)) & 0x0000ffff0000ffffull;
+	ret = ((ret << 16) | (ret >> 32)) & 0x00000000ffffffffull;
+
+	return ret;
+}
+
+inline u32 eight_bin_digits(const char* some_chars)
+{
+	return ((load_eight_chars(some_chars) & 0x0101010101010101ull)
+		* 0x8040201008040201ull) >> 56;
+}
+
+// These all return false if the number doesn't fit.  A decimal number has
+// to fit in an s64 (which is what it becomes), but hexadecimal and binary
+// numbers are bit patterns, so they can use all 64 bits.  some_digits must
+// contain only digits of the right base.
+inline bool parse_dec(std::string_view some_digits, u64& ret)
+{
+	ret = 0;
+	size_t i = 0;
+
+	for (; (i + 8) <= some_digits.size(); i += 8)
+	{
+		if (__builtin_mul_overflow(ret, 100000000ull, &ret)
+			|| __builtin_add_overflow(ret,
+			eight_dec_digits(some_digits.data() + i), &ret))
+		{
+			return false;
+		}
+	}
+
+	for (; i<some_digits.size(); ++i)
+	{
+		if (__builtin_mul_overflow(ret, 10ull, &ret)
+			|| __builtin_add_overflow(ret, some_digits[i] - '0', &ret))
+		{
+			return false;
+		}
+	}
+
+	return (ret <= static_cast<u64>(std::numeric_limits<s64>::max()));
+}
+
+inline bool parse_hex(std::string_view some_digits, u64& ret)
+{
+	ret = 0;
+
+	while ((some_digits.size() > 0) && (some_digits.front() == '0'))
+	{
+		some_digits.remove_prefix(1);
+	}
+
+	if (some_digits.size() > 16)
+	{
+		return false;
+	}
+
+	size_t i = 0;
+
+	for (; (i + 8) <= some_digits.size(); i += 8)
+	{
+		ret = (ret << 32) | eight_hex_digits(some_digits.data() + i);
+	}
+
+	for (; i<some_digits.size(); ++i)
+	{
+		const char c = some_digits[i];
+		ret = (ret << 4) | ((c & 0xf) + (((c & 0x40) >> 6) * 9));
+	}
+
+	return true;
+}
+
+inline bool parse_bin(std::string_view some_digits, u64& ret)
+{
+	ret = 0;
+
+	while ((some_digits.size() > 0) && (some_digits.front() == '0'))
+	{
+		some_digits.remove_prefix(1);
+	}
+
+	if (some_digits.size() > 64)
+	{
+		return false;
+	}
+
+	size_t i = 0;
+
+	for (; (i + 8) <= some_digits.size(); i += 8)
+	{
+		ret = (ret << 8) | eight_bin_digits(some_digits.data() + i);
+	}
+
+	for (; i<some_digits.size(); ++i)
+	{
+		ret = (ret << 1) | (some_digits[i] - '0');
+	}
+
+	return true;
+}
+
+
+// Single character punctuation and operators, indexed by the character
+constexpr std::array<PTok, 256> make_single_char_toks()
+{
+	std::array<PTok, 256> ret{};
+
+	#define TOKEN_STUFF(varname, value) \
+		static_assert(sizeof(value) == 2, \
+			"Tok::" #varname " isn't a single character"); \
+		ret[static_cast<u8>(value[0])] = &Tok::varname;
+
+	LIST_OF_PUNCT_TOKENS(TOKEN_STUFF)
+	LIST_OF_SINGLE_CHAR_OPERATOR_TOKENS(TOKEN_STUFF)
+
+	#undef TOKEN_STUFF
+
+	return ret;
+}
+
+inline constexpr std::array<PTok, 256> single_char_toks
+	= make_single_char_toks();
+
+
+// Directives go in a perfect hash table:  the seed for the hash function
+// is searched for at compile time such that no two directives collide.
+class DirectiveEntry
+{
+public:		// variables
+	std::string_view str;
+	PTok tok = nullptr;
+};
+
+#define TOKEN_STUFF(varname, value) + 1
+static constexpr size_t num_directives
+	= 0 LIST_OF_DIRECTIVE_TOKENS(TOKEN_STUFF);
+#undef TOKEN_STUFF
+
+static constexpr size_t directive_table_size = 64;
+static_assert((directive_table_size & (directive_table_size - 1)) == 0,
+	"directive_table_size must be a power of two");
+static_assert(num_directives <= (directive_table_size / 2),
+	"directive_table_size is too small");
+
+#define TOKEN_STUFF(varname, value) DirectiveEntry{value, &Tok::varname},
+inline constexpr std::array<DirectiveEntry, num_directives> directives
+	= {LIST_OF_DIRECTIVE_TOKENS(TOKEN_STUFF)};
+#undef TOKEN_STUFF
+
+// FNV-1a
+constexpr size_t directive_hash(std::string_view some_str, u32 some_seed)
+{
+	u32 ret = 2166136261u ^ some_seed;
+
+	for (const char c : some_str)
+	{
+		ret ^= static_cast<u8>(c);
+		ret *= 16777619u;
+	}
+
+	return (ret ^ (ret >> 16)) & (directive_table_size - 1);
+}
+
+constexpr u32 find_directive_seed()
+{
+	for (u32 seed=0; seed<(1 << 16); ++seed)
+	{
+		std::array<bool, directive_table_size> used{};
+		bool found = true;
+
+		for (const auto& directive : directives)
+		{
+			const size_t index = directive_hash(directive.str, seed);
+
+			if (used[index])
+			{
+				found = false;
+				break;
+			}
+			used[index] = true;
+		}
+
+		if (found)
+		{
+			return seed;
+		}
+	}
+
+	return static_cast<u32>(-1);
+}
+
+inline constexpr u32 directive_seed = find_directive_seed();
+static_assert(directive_seed != static_cast<u32>(-1),
+	"No perfect hash seed for the directives");
+
+constexpr std::array<DirectiveEntry, directive_table_size>
+	make_directive_table()
+{
+	std::array<DirectiveEntry, directive_table_size> ret{};
+
+	for (const auto& directive : directives)
+	{
+		ret[directive_hash(directive.str, directive_seed)] = directive;
+	}
+
+	return ret;
+}
+
+inline constexpr std::array<DirectiveEntry, directive_table_size>
+	directive_table = make_directive_table();
+
+// Returns nullptr if some_str isn't a directive
+inline PTok find_directive(std::string_view some_str)
+{
+	const DirectiveEntry& entry = directive_table[directive_hash(some_str,
+		directive_seed)];
+	return (entry.str == some_str) ? entry.tok : nullptr;
+}
+
+}
+
+}
+
+
+#endif		// lex_tables_hpp
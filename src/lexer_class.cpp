@@ -4,27 +4,27 @@ namespace flare32
 {
 
 
-void Lexer::need(const std::vector<ParseNode>& some_parse_vec, 
+void Lexer::need(ParseSpan some_parse_vec, 
 	size_t& index, PTok tok)
 {
 	//if (next_tok() == tok)
-	if (some_parse_vec.at(index).next_tok == tok)
+	if (some_parse_vec.at(index).next_tok_kind == tok->kind())
 	{
 		//lex();
 		++index;
 	}
 	else
 	{
-		printerr("need():  ");
+		osprintout(we().os(), "need():  ");
 		we().expected_tokens(tok);
 	}
 }
 
 void Lexer::__advance_innards(int& some_next_char, 
-	PTok& some_next_tok, std::string& some_next_sym_str,
+	PTok& some_next_tok, SymId& some_next_sym_id,
 	s64& some_next_num, size_t& some_line_num,  
 	size_t& some_outer_index, size_t& some_inner_index,
-	std::vector<std::string>* some_str_vec)
+	const std::vector<std::string_view>* some_str_vec)
 {
 	auto next_char = [&]() -> int
 	{
@@ -51,7 +51,7 @@ void Lexer::__advance_innards(int& some_next_char,
 			return EOF;
 		}
 
-		if (some_inner_index >= some_str_vec->at(some_outer_index).size())
+		if (some_inner_index >= (*some_str_vec)[some_outer_index].size())
 		{
 			some_inner_index = 0;
 			++some_outer_index;
@@ -71,8 +71,8 @@ void Lexer::__advance_innards(int& some_next_char,
 			}
 		}
 
-		const auto ret = some_str_vec->at(some_outer_index)
-			.at(some_inner_index++);
+		const auto ret = (*some_str_vec)[some_outer_index]
+			[some_inner_index++];
 
 		//printout("returning '");
 		//if (ret == '\n')
@@ -122,10 +122,10 @@ void Lexer::__advance_innards(int& some_next_char,
 
 void Lexer::__lex_innards(int& some_next_char, 
 	PTok& some_next_tok, PTok& some_prev_tok, 
-	std::string& some_next_sym_str,
+	SymId& some_next_sym_id,
 	s64& some_next_num, size_t& some_line_num,
 	size_t& some_outer_index, size_t& some_inner_index,
-	std::vector<std::string>* some_str_vec,
+	const std::vector<std::string_view>* some_str_vec,
 	ParsePos* pos)
 {
 	auto next_char = [&]() -> int
@@ -134,30 +134,20 @@ void Lexer::__lex_innards(int& some_next_char,
 	};
 
 
-	auto next_tok = [&]() -> PTok
-	{
-		return some_next_tok;
-	};
-
 	auto set_next_tok = [&](PTok tok) -> void
 	{
 		some_prev_tok = some_next_tok;
 		some_next_tok = tok;
 	};
 
-	auto prev_tok = [&]() -> PTok
-	{
-		return some_prev_tok;
-	};
-
 	//auto next_sym_str = [&]() -> const std::string&
 	//{
 	//	return some_next_sym_str;
 	//};
 
-	auto set_next_sym_str = [&](const std::string& n_next_sym_str) -> void
+	auto set_next_sym_id = [&](SymId n_next_sym_id) -> void
 	{
-		some_next_sym_str = n_next_sym_str;
+		some_next_sym_id = n_next_sym_id;
 	};
 
 	auto next_num = [&]() -> s64
@@ -172,7 +162,7 @@ void Lexer::__lex_innards(int& some_next_char,
 	auto call_advance = [&]() -> void
 	{
 		__advance_innards(some_next_char, some_next_tok,
-			some_next_sym_str, some_next_num, some_line_num,  
+			some_next_sym_id, some_next_num, some_line_num,  
 			some_outer_index, some_inner_index, some_str_vec);
 		//switch (next_char())
 		//{
@@ -190,8 +180,41 @@ void Lexer::__lex_innards(int& some_next_char,
 		//}
 	};
 
+	// When lexing from lines, a literal's digits are all on the current
+	// line, so they can be converted all at once.  next_char() is the
+	// first digit.
+	auto lex_literal = [&](u8 some_class, 
+		bool (*some_parse)(std::string_view, u64&)) -> void
+	{
+		const std::string_view line = (*some_str_vec)[some_outer_index];
+		const size_t start = some_inner_index - 1;
+		const size_t end = lex_tables::skip_class(line, start, some_class);
+		u64 value;
+
+		if (!some_parse(line.substr(start, end - start), value))
+		{
+			// The line number only goes up at the end of the line
+			++some_line_num;
+			we().err("Natural number is too large");
+		}
+
+		set_next_num(static_cast<s64>(value));
+		some_inner_index = end;
+		call_advance();
+	};
+
+
+	// When lexing from lines, jump straight over runs of whitespace.
+	if ((some_str_vec != nullptr)
+		&& (some_outer_index < some_str_vec->size())
+		&& (lex_tables::char_class(next_char()) & lex_tables::cc_space))
+	{
+		some_inner_index = lex_tables::skip_spaces((*some_str_vec)
+			[some_outer_index], some_inner_index);
+		call_advance();
+	}
 
-	while (isspace(next_char()) && (next_char() != '\n'))
+	while (lex_tables::char_class(next_char()) & lex_tables::cc_space)
 	//while (isspace(next_char()) && (next_char() != '\n')
 	//	&& (next_char() != EOF))
 	{
@@ -228,26 +251,17 @@ void Lexer::__lex_innards(int& some_next_char,
 	if (next_char() == '.')
 	{
 		call_advance();
-		while (isalnum(next_char()) || next_char() == '_')
+		while (lex_tables::char_class(next_char()) & lex_tables::cc_ident)
 		{
 			next_str += next_char();
 			call_advance();
 		}
 
-		if (next_str == "")
+		if (const PTok tok = lex_tables::find_directive(next_str))
 		{
+			set_next_tok(tok);
+			return;
 		}
-
-		#define TOKEN_STUFF(varname, value) \
-			else if (next_str == Tok::varname.str()) \
-			{ \
-				set_next_tok(&Tok::varname); \
-				return; \
-			}
-
-		LIST_OF_DIRECTIVE_TOKENS(TOKEN_STUFF)
-		#undef TOKEN_STUFF
-
 		else
 		{
 			we().err("Invalid assembler directive");
@@ -256,22 +270,33 @@ void Lexer::__lex_innards(int& some_next_char,
 
 
 
-	if (next_str == "")
+	if (const PTok tok = lex_tables::single_char_toks
+		[static_cast<u8>(next_char())])
 	{
-	}
+		set_next_tok(tok);
+
+		// Nothing after a comment token means anything, so when lexing
+		// from lines, the rest of the line is skipped in one step (the
+		// line's newline is still lexed).
+		if ((tok->props() & TokProp::Comment)
+			&& (some_str_vec != nullptr)
+			&& (some_outer_index < some_str_vec->size()))
+		{
+			const std::string_view line 
+				= (*some_str_vec)[some_outer_index];
+			size_t line_end = line.size();
 
-	#define TOKEN_STUFF(varname, value) \
-		else if (next_str == Tok::varname.str()) \
-		{ \
-			set_next_tok(&Tok::varname); \
-			call_advance(); \
-			return; \
-		}
+			if ((line_end > 0) && (line[line_end - 1] == '\n'))
+			{
+				--line_end;
+			}
 
-	LIST_OF_PUNCT_TOKENS(TOKEN_STUFF)
-	LIST_OF_SINGLE_CHAR_OPERATOR_TOKENS(TOKEN_STUFF)
+			some_inner_index = std::max(some_inner_index, line_end);
+		}
 
-	#undef TOKEN_STUFF
+		call_advance();
+		return;
+	}
 
 
 	//// Find a .define name
@@ -285,98 +310,82 @@ void Lexer::__lex_innards(int& some_next_char,
 	//}
 
 	// Find an identifier
-	if (isalpha(next_char()) || (next_char() == '_')
-		|| (next_char() == '`'))
+	if (lex_tables::char_class(next_char()) & lex_tables::cc_ident_start)
 	{
 		//printout("lex():  An ident?\n");
-		next_str = "";
-		next_str += next_char();
-		call_advance();
+		std::string_view ident;
 
-		while (isalnum(next_char()) || (next_char() == '_'))
+		// When lexing from lines, the identifier is just a view into the
+		// current line.
+		if (some_str_vec != nullptr)
 		{
-			next_str += next_char();
+			const std::string_view line 
+				= (*some_str_vec)[some_outer_index];
+			const size_t start = some_inner_index - 1;
+			size_t end = lex_tables::skip_class(line, start + 1,
+				lex_tables::cc_ident);
+
+			if ((end < line.size()) && (line[end] == '.'))
+			{
+				end = lex_tables::skip_class(line, end + 1,
+					lex_tables::cc_ident);
+			}
+
+			ident = line.substr(start, end - start);
+			some_inner_index = end;
 			call_advance();
 		}
-
-		if (next_char() == '.')
+		else
 		{
+			next_str = "";
 			next_str += next_char();
 			call_advance();
 
-			while (isalnum(next_char()) || (next_char() == '_'))
+			while (lex_tables::char_class(next_char())
+				& lex_tables::cc_ident)
 			{
 				next_str += next_char();
 				call_advance();
 			}
-		}
 
-		// Defines must start with "`"
-		if (next_str.front() == '`')
-		{
-			if (!user_sym_tbl().contains(next_str))
+			if (next_char() == '.')
 			{
-				// Need to use next_tok() here because we haven't
-				// set_next_tok() yet.
-				if (((prev_tok() == &Tok::Newline)
-					|| (prev_tok() == nullptr))
-					&& (next_tok() != &Tok::DotDef))
+				next_str += next_char();
+				call_advance();
+
+				while (lex_tables::char_class(next_char())
+					& lex_tables::cc_ident)
 				{
-					we().err("Undefined .def (perhaps just not YET ",
-						"defined?)");
+					next_str += next_char();
+					call_advance();
 				}
-
-				Symbol to_insert(next_str, &Tok::Ident, 0,
-					SymType::DefineName);
-
-				user_sym_tbl().insert_or_assign(to_insert);
-			}
-		}
-		// If we haven't seen a user symbol like this before...
-		else if (!user_sym_tbl().contains(next_str))
-		{
-			// ...Then create a new symbol
-			//printout("Creating a new symbol....\n");
-			Symbol to_insert(next_str, &Tok::Ident, 0);
-
-
-			// Need to use next_tok() here because we haven't
-			// set_next_tok() yet.
-			#define TOKEN_STUFF(varname, value) \
-				(next_tok() == &Tok::varname) ||
-			if (LIST_OF_EQUATE_DIRECTIVE_TOKENS(TOKEN_STUFF) false)
-			{
-				to_insert.set_type(SymType::EquateName);
-			}
-			#undef TOKEN_STUFF
-			//else if (next_tok() == &Tok::DotDef)
-			//{
-			//	to_insert.set_type(SymType::DefineName);
-			//}
-			else
-			{
-				to_insert.set_type(SymType::Other);
 			}
-			
-			//printout((int)to_insert.type(), "\n");
 
-			user_sym_tbl().insert_or_assign(to_insert);
+			ident = next_str;
 		}
 
+		// User symbols aren't created here, only where they're defined
+		// (see Assembler::define_sym()).
+		const SymId next_sym_id = ident_pool().intern(ident);
+
 
 		//printout("lex():  next_str, next_char():  ", next_str, ", ",
 		//	(char)next_char(), "\n");
-		if (builtin_sym_tbl().contains(next_str))
+		if (const builtin_syms::Entry* builtin 
+			= builtin_syms::at(next_sym_id))
 		{
-			const Symbol& temp = builtin_sym_tbl().at(next_str);
-			set_next_tok(temp.token());
+			set_next_tok(builtin->tok);
+
+			// Registers are resolved to their numbers right here, so
+			// that encoding doesn't have to look them up again.
+			set_next_num(builtin->value);
 		}
 		else
 		{
 			set_next_tok(&Tok::Ident);
 		}
 
-		set_next_sym_str(next_str);
+		set_next_sym_id(next_sym_id);
 
 		return;
 	}
@@ -389,7 +398,7 @@ void Lexer::__lex_innards(int& some_next_char,
 
 		call_advance();
 
-		if (isdigit(next_char()))
+		if (lex_tables::char_class(next_char()) & lex_tables::cc_digit)
 		{
 			we().expected("Natural number that does not start with 0!");
 		}
@@ -404,6 +413,11 @@ void Lexer::__lex_innards(int& some_next_char,
 				we().expected("Hexadecimal number");
 			}
 
+			if (some_str_vec != nullptr)
+			{
+				lex_literal(lex_tables::cc_xdigit, lex_tables::parse_hex);
+			}
+
 			while (isxdigit(next_char()))
 			{
 				if ((next_char() >= 'a') && (next_char() <= 'f'))
@@ -435,6 +449,11 @@ void Lexer::__lex_innards(int& some_next_char,
 				we().expected("Binary number");
 			}
 
+			if (some_str_vec != nullptr)
+			{
+				lex_literal(lex_tables::cc_bdigit, lex_tables::parse_bin);
+			}
+
 			while ((next_char() == '0') || (next_char() == '1'))
 			{
 				set_next_num((next_num() * 2) + (next_char() - '0'));
@@ -447,15 +466,20 @@ void Lexer::__lex_innards(int& some_next_char,
 	}
 
 	// Find a constant natural number
-	if (isdigit(next_char()))
+	if (lex_tables::char_class(next_char()) & lex_tables::cc_digit)
 	{
 		set_next_num(0);
 
-		do
+		if (some_str_vec != nullptr)
+		{
+			lex_literal(lex_tables::cc_digit, lex_tables::parse_dec);
+		}
+
+		while (lex_tables::char_class(next_char()) & lex_tables::cc_digit)
 		{
 			set_next_num((next_num() * 10) + (next_char() - '0'));
 			call_advance();
-		} while (isdigit(next_char()));
+		}
 
 		set_next_tok(&Tok::NatNum);
 
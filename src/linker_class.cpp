@@ -0,0 +1,164 @@
+#include "linker_class.hpp"
+
+namespace flare32
+{
+
+void Linker::link(const std::vector<std::string>& some_filenames,
+	OutputBuffer& ret)
+{
+	__filenames = some_filenames;
+
+	__read_objects();
+	__find_exports();
+
+	for (size_t i=0; i<__objects.size(); ++i)
+	{
+		for (const auto& reloc : __objects[i].relocs)
+		{
+			__apply_reloc(i, reloc);
+		}
+
+		for (auto& segment : __objects[i].segments)
+		{
+			segment.start_addr += __section_addrs[i];
+			ret.append(std::move(segment));
+		}
+	}
+}
+
+void Linker::__read_objects()
+{
+	size_t section_addr = 0;
+
+	__objects.resize(__filenames.size());
+	__section_addrs.resize(__filenames.size());
+
+	for (size_t i=0; i<__filenames.size(); ++i)
+	{
+		FILE* infile = fopen(__filenames[i].c_str(), "rb");
+
+		if (infile == nullptr)
+		{
+			we().fail("Error:  Cannot read file \"", __filenames[i],
+				"\"\n");
+		}
+
+		const bool ok = __objects[i].read(infile);
+		fclose(infile);
+
+		if (!ok)
+		{
+			we().fail("Error:  \"", __filenames[i], "\" isn't a valid ",
+				"object file\n");
+		}
+
+		__section_addrs[i] = section_addr;
+		section_addr += __objects[i].section_size();
+		section_addr = (section_addr + section_align - 1)
+			& ~(section_align - 1);
+	}
+}
+
+void Linker::__find_exports()
+{
+	// Which file each export came from, for error messages
+	std::map<std::string_view, size_t> export_files;
+
+	for (size_t i=0; i<__objects.size(); ++i)
+	{
+		for (const auto& sym : __objects[i].syms)
+		{
+			if (sym.kind == ObjectFile::SymKind::Import)
+			{
+				continue;
+			}
+
+			if (export_files.count(sym.name) != 0)
+			{
+				we().fail("Error:  \"", sym.name, "\" is defined in both ",
+					"\"", __filenames[export_files.at(sym.name)], "\" and \"",
+					__filenames[i], "\"\n");
+			}
+
+			export_files[sym.name] = i;
+			__exports[sym.name] = sym.value
+				+ ((sym.kind == ObjectFile::SymKind::Section)
+				? __section_addrs[i] : 0);
+		}
+	}
+}
+
+void Linker::__apply_reloc(size_t some_object_index,
+	const Relocation& some_reloc)
+{
+	ObjectFile& object = __objects[some_object_index];
+	const size_t section_addr = __section_addrs[some_object_index];
+	s64 value = some_reloc.addend;
+
+	switch (some_reloc.target)
+	{
+		case RelocTarget::Absolute:
+			break;
+
+		case RelocTarget::Section:
+			value += section_addr;
+			break;
+
+		case RelocTarget::Symbol:
+			{
+				const std::string& name = object.syms.at(some_reloc.sym)
+					.name;
+				const auto iter = __exports.find(name);
+
+				if (iter == __exports.end())
+				{
+					we().fail("Error:  \"", name, "\" (used in \"",
+						__filenames[some_object_index], "\") isn't ",
+						"defined in any object file\n");
+				}
+
+				value += iter->second;
+			}
+			break;
+	}
+
+	size_t size = 2;
+
+	switch (some_reloc.type)
+	{
+		case RelocType::Imm16:
+			break;
+
+		case RelocType::Imm32:
+			size = 4;
+			break;
+
+		case RelocType::Branch16:
+			// Relative to the end of the branch, and the field is its
+			// last halfword
+			value -= section_addr + some_reloc.addr + size;
+			break;
+	}
+
+	// Later segments overwrite earlier ones, so the last one with the
+	// field in it is the one that counts
+	for (auto iter=object.segments.rbegin(); iter!=object.segments.rend();
+		++iter)
+	{
+		if ((some_reloc.addr >= iter->start_addr)
+			&& ((some_reloc.addr + size) <= iter->end_addr()))
+		{
+			for (size_t i=0; i<size; ++i)
+			{
+				iter->data[some_reloc.addr - iter->start_addr + i]
+					= value >> ((size - 1 - i) * 8);
+			}
+			return;
+		}
+	}
+
+	we().fail("Error:  \"", __filenames[some_object_index], "\" has a ",
+		"relocation outside of its section\n");
+}
+
+}
@@ -0,0 +1,58 @@
+#ifndef linker_class_hpp
+#define linker_class_hpp
+
+#include "misc_includes.hpp"
+
+#include "warn_error_class.hpp"
+#include "output_buffer_class.hpp"
+#include "object_file_class.hpp"
+
+namespace flare32
+{
+
+// Links object files together.  Their sections are put one after another,
+// in the order the files are given, starting at address 0 (each one
+// aligned to section_align bytes).  Then every relocation gets filled in.
+class Linker
+{
+private:		// constants
+	static constexpr size_t section_align = 4;
+
+private:		// variables
+	WarnError* __we = nullptr;
+
+	std::vector<std::string> __filenames;
+	std::vector<ObjectFile> __objects;
+
+	// Where each of __objects' sections goes
+	std::vector<size_t> __section_addrs;
+
+	// Every exported symbol's final value
+	std::map<std::string, s64, std::less<>> __exports;
+
+public:		// functions
+	inline Linker(WarnError* s_we)
+		: __we(s_we)
+	{
+	}
+
+	// Links the object files named some_filenames into ret
+	void link(const std::vector<std::string>& some_filenames,
+		OutputBuffer& ret);
+
+private:		// functions
+	void __read_objects();
+	void __find_exports();
+	void __apply_reloc(size_t some_object_index,
+		const Relocation& some_reloc);
+
+	inline auto& we() const
+	{
+		return *__we;
+	}
+};
+
+}
+
+
+#endif		// linker_class_hpp
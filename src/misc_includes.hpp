@@ -3,6 +3,17 @@
 
 #include <map>
 #include <set>
+#include <deque>
+#include <array>
+#include <string_view>
+#include <stdexcept>
+#include <cstring>
+#include <sstream>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <fstream>
+#include <limits>
 
 #include "liborangepower_src/misc_includes.hpp"
 #include "liborangepower_src/misc_defines.hpp"
@@ -0,0 +1,147 @@
+#include "object_file_class.hpp"
+
+namespace flare32
+{
+
+size_t ObjectFile::section_size() const
+{
+	size_t ret = 0;
+
+	for (const auto& segment : segments)
+	{
+		ret = std::max(ret, segment.end_addr());
+	}
+
+	return ret;
+}
+
+void ObjectFile::write(FILE* some_outfile) const
+{
+	std::string data = magic;
+	append_u32(data, version);
+
+	append_u32(data, segments.size());
+
+	for (const auto& segment : segments)
+	{
+		append_u32(data, segment.start_addr);
+		append_u32(data, segment.data.size());
+		data.append(segment.data.begin(), segment.data.end());
+
+		append_u32(data, segment.item_ends.size());
+
+		for (const size_t item_end : segment.item_ends)
+		{
+			append_u32(data, item_end);
+		}
+	}
+
+	append_u32(data, syms.size());
+
+	for (const auto& sym : syms)
+	{
+		append_u8(data, static_cast<u8>(sym.kind));
+		append_u32(data, sym.value);
+		append_u32(data, sym.name.size());
+		data += sym.name;
+	}
+
+	append_u32(data, relocs.size());
+
+	for (const auto& reloc : relocs)
+	{
+		append_u8(data, static_cast<u8>(reloc.type));
+		append_u8(data, static_cast<u8>(reloc.target));
+		append_u32(data, reloc.addr);
+		append_u32(data, reloc.sym);
+		append_u32(data, reloc.addend);
+	}
+
+	fwrite(data.data(), 1, data.size(), some_outfile);
+	fflush(some_outfile);
+}
+
+bool ObjectFile::read(FILE* some_infile)
+{
+	segments.clear();
+	syms.clear();
+	relocs.clear();
+
+	std::string data;
+	read_whole_file(some_infile, data);
+
+	BinaryReader reader(data);
+	std::string_view bytes;
+
+	if (!reader.read_bytes(sizeof(magic) - 1, bytes) || (bytes != magic)
+		|| (reader.read_u32() != version))
+	{
+		return false;
+	}
+
+	for (u32 i=reader.read_u32(); (i>0) && reader.ok(); --i)
+	{
+		OutputBuffer::Segment segment(reader.read_u32());
+
+		if (!reader.read_bytes(reader.read_u32(), bytes))
+		{
+			return false;
+		}
+
+		segment.data.assign(bytes.begin(), bytes.end());
+
+		for (u32 j=reader.read_u32(); (j>0) && reader.ok(); --j)
+		{
+			segment.item_ends.push_back(reader.read_u32());
+
+			if (segment.item_ends.back() > segment.data.size())
+			{
+				return false;
+			}
+		}
+
+		segments.push_back(std::move(segment));
+	}
+
+	for (u32 i=reader.read_u32(); (i>0) && reader.ok(); --i)
+	{
+		Sym sym;
+		const u8 kind = reader.read_u8();
+		sym.value = static_cast<s32>(reader.read_u32());
+
+		if ((kind > static_cast<u8>(SymKind::Import))
+			|| !reader.read_bytes(reader.read_u32(), bytes))
+		{
+			return false;
+		}
+
+		sym.kind = static_cast<SymKind>(kind);
+		sym.name = bytes;
+		syms.push_back(std::move(sym));
+	}
+
+	for (u32 i=reader.read_u32(); (i>0) && reader.ok(); --i)
+	{
+		Relocation reloc;
+		const u8 type = reader.read_u8(), target = reader.read_u8();
+		reloc.addr = reader.read_u32();
+		reloc.sym = reader.read_u32();
+		reloc.addend = static_cast<s32>(reader.read_u32());
+
+		if ((type > static_cast<u8>(RelocType::Branch16))
+			|| (target > static_cast<u8>(RelocTarget::Symbol))
+			|| ((static_cast<RelocTarget>(target) == RelocTarget::Symbol)
+			&& (reloc.sym >= syms.size())))
+		{
+			return false;
+		}
+
+		reloc.type = static_cast<RelocType>(type);
+		reloc.target = static_cast<RelocTarget>(target);
+		relocs.push_back(reloc);
+	}
+
+	return (reader.ok() && reader.at_end());
+}
+
+}
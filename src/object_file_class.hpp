@@ -0,0 +1,92 @@
+#ifndef object_file_class_hpp
+#define object_file_class_hpp
+
+#include "misc_includes.hpp"
+#include "output_buffer_class.hpp"
+#include "binary_file_funcs.hpp"
+
+namespace flare32
+{
+
+// A relocatable object file, as written by the -c option and read by the
+// linker (the -l option).
+//
+// Everything in an object file is in one section, whose addresses start
+// at 0, and the linker decides where the section really goes.  All
+// numbers are little-endian:
+//
+//	"F32O", u32 version
+//	u32 num_segments, then for each one:
+//		u32 start_addr, u32 size, u8 data[size],
+//		u32 num_item_ends, u32 item_ends[num_item_ends]
+//	u32 num_syms, then for each one:
+//		u8 kind, u32 value, u32 name_size, char name[name_size]
+//	u32 num_relocs, then for each one:
+//		u8 type, u8 target, u32 addr, u32 sym, u32 addend
+class ObjectFile
+{
+public:		// classes
+	enum class SymKind : u8
+	{
+		// Exported, with a value that doesn't depend on where the
+		// section goes (an equate)
+		Absolute,
+
+		// Exported, with a value that's an address in the section
+		Section,
+
+		// Defined by some other object file
+		Import,
+	};
+
+	class Sym
+	{
+	public:		// variables
+		std::string name;
+		SymKind kind = SymKind::Absolute;
+		s64 value = 0;
+
+	public:		// functions
+		inline Sym()
+		{
+		}
+		inline Sym(std::string_view s_name, SymKind s_kind, s64 s_value)
+			: name(s_name), kind(s_kind), value(s_value)
+		{
+		}
+
+		inline Sym(const Sym& to_copy) = default;
+		inline Sym(Sym&& to_move) = default;
+		inline Sym& operator = (const Sym& to_copy) = default;
+		inline Sym& operator = (Sym&& to_move) = default;
+	};
+
+private:		// constants
+	static constexpr char magic[] = "F32O";
+	static constexpr u32 version = 1;
+
+public:		// variables
+	std::vector<OutputBuffer::Segment> segments;
+	std::vector<Sym> syms;
+
+	// Each one's sym is an index into syms
+	std::vector<Relocation> relocs;
+
+public:		// functions
+	inline ObjectFile()
+	{
+	}
+
+	// Where the section ends, i.e. how much room it needs
+	size_t section_size() const;
+
+	void write(FILE* some_outfile) const;
+
+	// Returns false if some_infile isn't a valid object file
+	bool read(FILE* some_infile);
+};
+
+}
+
+
+#endif		// object_file_class_hpp
@@ -4,29 +4,38 @@
 
 #include "misc_includes.hpp"
 
-
-#include "symbol_table_class.hpp"
-#include "define_table_class.hpp"
-
-#include "parse_node_class.hpp"
-#include "lexer_class.hpp"
-#include "code_generator_class.hpp"
+#include "output_buffer_class.hpp"
 
 namespace flare32
 {
 
-enum class OutType
-{
-	Orig,
-	//Binary,
-};
-
-
 class Options
 {
 public:		// variables
-	OutType out_type;
+	OutType out_type = OutType::Orig;
+
+	// Assemble in one pass, patching forward references at the end
+	bool single_pass = false;
+
+	// How many threads to use (0 means one per hardware thread)
+	size_t num_threads = 0;
+
+	// Assemble every input file into its own output file, instead of
+	// just one input file to standard output
+	bool batch = false;
+
+	// Write a relocatable object file instead of out_type
+	bool object = false;
+
+	// Link object files together instead of assembling anything
+	bool link = false;
+
+	// Reuse whatever hasn't changed since the last time the input file
+	// was assembled (see IncrementalCache)
+	bool incremental = false;
 
+	// If not empty, the directory to keep a BuildCache in
+	std::string cache_dir;
 };
 
 }
@@ -0,0 +1,286 @@
+#include "output_buffer_class.hpp"
+
+namespace flare32
+{
+
+// Text output is formatted into a large chunk and only fwrite()'d when
+// the chunk is full.
+static constexpr size_t text_chunk_size = 1 << 16;
+
+static void append_hex(std::string& text, u32 v, size_t num_digits,
+	bool uppercase=false)
+{
+	static constexpr char lower_hex_digits[] = "0123456789abcdef";
+	static constexpr char upper_hex_digits[] = "0123456789ABCDEF";
+
+	const char* hex_digits = uppercase ? upper_hex_digits
+		: lower_hex_digits;
+
+	for (size_t i=num_digits; i>0; --i)
+	{
+		text += hex_digits[(v >> ((i - 1) * 4)) & 0xf];
+	}
+}
+
+static void write_text_if_full(std::string& text, FILE* some_outfile)
+{
+	if (text.size() >= text_chunk_size)
+	{
+		fwrite(text.data(), 1, text.size(), some_outfile);
+		text.clear();
+	}
+}
+
+
+void OutputBuffer::flush(FILE* some_outfile, OutType some_out_type)
+{
+	switch (some_out_type)
+	{
+		case OutType::Orig:
+			__write_orig(some_outfile);
+			break;
+
+		case OutType::Binary:
+			__write_binary(some_outfile);
+			break;
+
+		case OutType::IntelHex:
+			__write_intel_hex(some_outfile);
+			break;
+
+		case OutType::SRecord:
+			__write_srecord(some_outfile);
+			break;
+	}
+
+	fflush(some_outfile);
+	clear();
+}
+
+bool OutputBuffer::since_mark(const Mark& some_mark,
+	std::vector<u8>& ret_data, std::vector<u32>& ret_item_ends) const
+{
+	ret_data.clear();
+	ret_item_ends.clear();
+
+	size_t first_data = some_mark.data_size,
+		first_item_end = some_mark.num_item_ends;
+
+	if (__segments.size() == some_mark.num_segments)
+	{
+		if (__segments.size() == 0)
+		{
+			return true;
+		}
+	}
+
+	// Started a new segment
+	else if (__segments.size() == (some_mark.num_segments + 1))
+	{
+		first_data = 0;
+		first_item_end = 0;
+	}
+	else
+	{
+		return false;
+	}
+
+	const Segment& segment = __segments.back();
+
+	ret_data.assign(segment.data.begin() + first_data,
+		segment.data.end());
+
+	for (size_t i=first_item_end; i<segment.item_ends.size(); ++i)
+	{
+		ret_item_ends.push_back(segment.item_ends[i] - first_data);
+	}
+
+	return true;
+}
+
+void OutputBuffer::__write_orig(FILE* some_outfile) const
+{
+	std::string text;
+	text.reserve(text_chunk_size + 64);
+
+	for (const auto& segment : __segments)
+	{
+		// "@address" whenever the address jumps
+		text += '@';
+		append_hex(text, static_cast<u32>(segment.start_addr), 8);
+		text += '\n';
+
+		size_t item_index = 0;
+
+		for (size_t i=0; i<segment.data.size(); ++i)
+		{
+			append_hex(text, segment.data[i], 2);
+			text += '\n';
+
+			// Blank line after every instruction or .db/.dw value
+			while ((item_index < segment.item_ends.size())
+				&& (segment.item_ends[item_index] == (i + 1)))
+			{
+				text += '\n';
+				++item_index;
+			}
+
+			write_text_if_full(text, some_outfile);
+		}
+	}
+
+	fwrite(text.data(), 1, text.size(), some_outfile);
+}
+
+void OutputBuffer::__write_binary(FILE* some_outfile) const
+{
+	if (__segments.size() == 0)
+	{
+		return;
+	}
+
+	size_t start_addr = __segments.front().start_addr,
+		end_addr = __segments.front().end_addr();
+
+	for (const auto& segment : __segments)
+	{
+		start_addr = std::min(start_addr, segment.start_addr);
+		end_addr = std::max(end_addr, segment.end_addr());
+	}
+
+	// Gaps between segments are filled with zeros.  Later segments
+	// overwrite earlier ones, just like .org says they do.
+	std::vector<u8> image(end_addr - start_addr, 0);
+
+	for (const auto& segment : __segments)
+	{
+		std::copy(segment.data.begin(), segment.data.end(),
+			image.begin() + (segment.start_addr - start_addr));
+	}
+
+	fwrite(image.data(), 1, image.size(), some_outfile);
+}
+
+void OutputBuffer::__write_intel_hex(FILE* some_outfile) const
+{
+	static constexpr size_t max_record_size = 16;
+
+	std::string text;
+	text.reserve(text_chunk_size + 64);
+
+	auto append_record = [&](u8 type, u16 offset, const u8* data,
+		size_t size) -> void
+	{
+		u8 checksum = size + (offset >> 8) + offset + type;
+
+		text += ':';
+		append_hex(text, size, 2, true);
+		append_hex(text, offset, 4, true);
+		append_hex(text, type, 2, true);
+
+		for (size_t i=0; i<size; ++i)
+		{
+			append_hex(text, data[i], 2, true);
+			checksum += data[i];
+		}
+
+		append_hex(text, static_cast<u8>(-checksum), 2, true);
+		text += '\n';
+
+		write_text_if_full(text, some_outfile);
+	};
+
+	// The upper 16 bits of the address, as set by the last Extended
+	// Linear Address record
+	u32 upper_addr = 0;
+
+	for (const auto& segment : __segments)
+	{
+		size_t i = 0;
+
+		while (i < segment.data.size())
+		{
+			const u32 some_addr = segment.start_addr + i;
+
+			if ((some_addr >> 16) != upper_addr)
+			{
+				upper_addr = some_addr >> 16;
+				const u8 upper_data[] = {static_cast<u8>(upper_addr >> 8),
+					static_cast<u8>(upper_addr)};
+				append_record(0x04, 0, upper_data, sizeof(upper_data));
+			}
+
+			// Records can't cross a 64 KiB boundary
+			const size_t size = std::min({max_record_size,
+				segment.data.size() - i,
+				static_cast<size_t>(0x10000 - (some_addr & 0xffff))});
+
+			append_record(0x00, some_addr, segment.data.data() + i, size);
+
+			i += size;
+		}
+	}
+
+	// End of File record
+	append_record(0x01, 0, nullptr, 0);
+
+	fwrite(text.data(), 1, text.size(), some_outfile);
+}
+
+void OutputBuffer::__write_srecord(FILE* some_outfile) const
+{
+	static constexpr size_t max_record_size = 16;
+
+	std::string text;
+	text.reserve(text_chunk_size + 64);
+
+	// Always use 32-bit addresses (S3 data records, S7 termination)
+	auto append_record = [&](char type, u32 some_addr, const u8* data,
+		size_t size, size_t addr_size) -> void
+	{
+		const u8 count = addr_size + size + 1;
+		u8 checksum = count;
+
+		text += 'S';
+		text += type;
+		append_hex(text, count, 2, true);
+
+		for (size_t i=addr_size; i>0; --i)
+		{
+			const u8 addr_byte = some_addr >> ((i - 1) * 8);
+			append_hex(text, addr_byte, 2, true);
+			checksum += addr_byte;
+		}
+
+		for (size_t i=0; i<size; ++i)
+		{
+			append_hex(text, data[i], 2, true);
+			checksum += data[i];
+		}
+
+		append_hex(text, static_cast<u8>(~checksum), 2, true);
+		text += '\n';
+
+		write_text_if_full(text, some_outfile);
+	};
+
+	// Empty header
+	append_record('0', 0, nullptr, 0, 2);
+
+	for (const auto& segment : __segments)
+	{
+		for (size_t i=0; i<segment.data.size(); i+=max_record_size)
+		{
+			append_record('3', segment.start_addr + i,
+				segment.data.data() + i,
+				std::min(max_record_size, segment.data.size() - i), 4);
+		}
+	}
+
+	// Termination, with a start address of 0
+	append_record('7', 0, nullptr, 0, 4);
+
+	fwrite(text.data(), 1, text.size(), some_outfile);
+}
+
+}
@@ -0,0 +1,301 @@
+#ifndef output_buffer_class_hpp
+#define output_buffer_class_hpp
+
+#include "misc_includes.hpp"
+
+namespace flare32
+{
+
+enum class OutType
+{
+	// "@address" lines followed by one hex byte per line
+	Orig,
+
+	// Flat binary image, starting at the lowest address used
+	Binary,
+
+	IntelHex,
+	SRecord,
+};
+
+// The fields of an instruction (or .dw value) that the linker can fill in
+enum class RelocType : u8
+{
+	// The low halfword of a group 1 instruction
+	Imm16,
+
+	// The low word of a group 3 instruction, or a .dw value
+	Imm32,
+
+	// The low halfword of a branch, which is relative to the address
+	// right after the branch
+	Branch16,
+};
+
+// What a relocated field's value is relative to
+enum class RelocTarget : u8
+{
+	// Address 0, i.e. nothing (only needed by branches)
+	Absolute,
+
+	// Wherever the linker puts the object file's section
+	Section,
+
+	// A symbol defined in some other object file
+	Symbol,
+};
+
+class Relocation
+{
+public:		// variables
+	RelocType type = RelocType::Imm16;
+	RelocTarget target = RelocTarget::Absolute;
+
+	// The address of the field
+	size_t addr = 0;
+
+	// RelocTarget::Symbol only:  which symbol (a SymId in the assembler,
+	// or an index into ObjectFile::syms)
+	size_t sym = 0;
+
+	// Added to the target's address
+	s64 addend = 0;
+
+public:		// functions
+	inline Relocation()
+	{
+	}
+	inline Relocation(RelocType s_type, RelocTarget s_target,
+		size_t s_addr, size_t s_sym, s64 s_addend)
+		: type(s_type), target(s_target), addr(s_addr), sym(s_sym),
+		addend(s_addend)
+	{
+	}
+
+	inline Relocation(const Relocation& to_copy) = default;
+	inline Relocation& operator = (const Relocation& to_copy) = default;
+};
+
+// Holds the generated binary in memory so that it can be written out all
+// at once, instead of one printf() per byte.
+//
+// Flush policy:  nothing at all is written until flush() is called, which
+// the Assembler does exactly once, after the last pass has finished.
+class OutputBuffer
+{
+public:		// classes
+	// A run of bytes at consecutive addresses
+	class Segment
+	{
+	public:		// variables
+		size_t start_addr = 0;
+		std::vector<u8> data;
+
+		// Offsets into data at which an instruction or a .db/.dw value
+		// ends
+		std::vector<size_t> item_ends;
+
+	public:		// functions
+		inline Segment()
+		{
+		}
+		inline Segment(size_t s_start_addr)
+			: start_addr(s_start_addr)
+		{
+		}
+
+		inline Segment(const Segment& to_copy) = default;
+		inline Segment(Segment&& to_move) = default;
+		inline Segment& operator = (const Segment& to_copy) = default;
+		inline Segment& operator = (Segment&& to_move) = default;
+
+		inline size_t end_addr() const
+		{
+			return start_addr + data.size();
+		}
+	};
+
+	// How much had been generated at some point (see since_mark())
+	class Mark
+	{
+	public:		// variables
+		size_t num_segments = 0, data_size = 0, num_item_ends = 0;
+	};
+
+private:		// constants
+	static constexpr size_t not_patching = static_cast<size_t>(-1);
+
+private:		// variables
+	std::vector<Segment> __segments;
+
+	// While patching, gen8() overwrites bytes in this segment instead of
+	// appending new ones
+	size_t __patch_segment_index = not_patching;
+
+	// Only used when assembling an object file, indexed by the field's
+	// address.  A field that gets generated again (e.g. while patching)
+	// just replaces its old relocation.
+	std::map<size_t, Relocation> __relocs;
+
+public:		// functions
+	inline OutputBuffer()
+	{
+	}
+
+	inline void clear()
+	{
+		__segments.clear();
+		__patch_segment_index = not_patching;
+		__relocs.clear();
+	}
+
+	inline void gen8(size_t some_addr, u8 v)
+	{
+		if (__patch_segment_index != not_patching)
+		{
+			Segment& segment = __segments.at(__patch_segment_index);
+			segment.data.at(some_addr - segment.start_addr) = v;
+			return;
+		}
+
+		if ((__segments.size() == 0)
+			|| (__segments.back().end_addr() != some_addr))
+		{
+			__segments.push_back(Segment(some_addr));
+		}
+
+		__segments.back().data.push_back(v);
+	}
+
+	// Same as gen8()'ing each of some_data's bytes in turn, then
+	// end_item()'ing after each byte that one of some_item_ends (offsets
+	// into some_data) says ends an item.  Not for use while patching.
+	inline void gen(size_t some_addr, const u8* some_data, size_t some_size,
+		const u32* some_item_ends, size_t some_num_item_ends)
+	{
+		if (some_size == 0)
+		{
+			return;
+		}
+
+		if ((__segments.size() == 0)
+			|| (__segments.back().end_addr() != some_addr))
+		{
+			__segments.push_back(Segment(some_addr));
+		}
+
+		Segment& segment = __segments.back();
+		const size_t offset = segment.data.size();
+
+		segment.data.insert(segment.data.end(), some_data,
+			some_data + some_size);
+
+		for (size_t i=0; i<some_num_item_ends; ++i)
+		{
+			segment.item_ends.push_back(offset + some_item_ends[i]);
+		}
+	}
+
+	inline void end_item()
+	{
+		if ((__patch_segment_index == not_patching)
+			&& (__segments.size() != 0))
+		{
+			__segments.back().item_ends.push_back(__segments.back().data
+				.size());
+		}
+	}
+
+	// Add what's in to_append after everything that's already here, as
+	// if it had all been generated into this OutputBuffer
+	inline void append(OutputBuffer&& to_append)
+	{
+		for (auto& segment : to_append.__segments)
+		{
+			append(std::move(segment));
+		}
+
+		__relocs.merge(to_append.__relocs);
+
+		to_append.clear();
+	}
+	inline void append(Segment&& to_append)
+	{
+		if ((__segments.size() == 0)
+			|| (__segments.back().end_addr() != to_append.start_addr))
+		{
+			__segments.push_back(std::move(to_append));
+			return;
+		}
+
+		Segment& last = __segments.back();
+		const size_t offset = last.data.size();
+
+		last.data.insert(last.data.end(), to_append.data.begin(),
+			to_append.data.end());
+
+		for (const size_t item_end : to_append.item_ends)
+		{
+			last.item_ends.push_back(offset + item_end);
+		}
+	}
+
+	inline Mark mark() const
+	{
+		Mark ret;
+		ret.num_segments = __segments.size();
+
+		if (ret.num_segments != 0)
+		{
+			ret.data_size = __segments.back().data.size();
+			ret.num_item_ends = __segments.back().item_ends.size();
+		}
+
+		return ret;
+	}
+
+	// Everything generated since some_mark was made, if it's all in one
+	// segment (offsets in ret_item_ends are relative to ret_data).
+	// Returns false otherwise.
+	bool since_mark(const Mark& some_mark, std::vector<u8>& ret_data,
+		std::vector<u32>& ret_item_ends) const;
+
+	inline void set_reloc(const Relocation& some_reloc)
+	{
+		__relocs.insert_or_assign(some_reloc.addr, some_reloc);
+	}
+	inline void remove_reloc(size_t some_addr)
+	{
+		__relocs.erase(some_addr);
+	}
+
+	// Regenerate bytes that are already in the segment with index
+	// some_segment_index, e.g. once a forward reference is known
+	inline void begin_patch(size_t some_segment_index)
+	{
+		__patch_segment_index = some_segment_index;
+	}
+	inline void end_patch()
+	{
+		__patch_segment_index = not_patching;
+	}
+
+	// Write everything to some_outfile in the some_out_type format, then
+	// clear()
+	void flush(FILE* some_outfile, OutType some_out_type);
+
+	gen_getter_by_con_ref(segments);
+	gen_getter_by_con_ref(relocs);
+
+private:		// functions
+	void __write_orig(FILE* some_outfile) const;
+	void __write_binary(FILE* some_outfile) const;
+	void __write_intel_hex(FILE* some_outfile) const;
+	void __write_srecord(FILE* some_outfile) const;
+
+};
+
+}
+
+
+#endif		// output_buffer_class_hpp
@@ -21,29 +21,183 @@ public:		// variables
 class ParseNode
 {
 public:		// variables
-	PTok next_tok = nullptr;
-	std::string next_sym_str;
+	// The value of a NatNum, or the register number of a Reg
 	s64 next_num = -1;
 
+	SymId next_sym_id = IdentPool::bad_id;
+	TokKind next_tok_kind = TokKind::Lim;
+
 public:		// functions
 	inline ParseNode()
 	{
 	}
 
 
-	inline ParseNode(PTok s_next_tok, 
-		const std::string& s_next_sym_str, s64 s_next_num)
-		: next_tok(s_next_tok), next_sym_str(s_next_sym_str),
-		next_num(s_next_num)
+	inline ParseNode(PTok s_next_tok, SymId s_next_sym_id, 
+		s64 s_next_num)
+		: next_num(s_next_num), next_sym_id(s_next_sym_id),
+		next_tok_kind((s_next_tok != nullptr) ? s_next_tok->kind()
+			: TokKind::Lim)
 	{
 	}
 
+	inline PTok next_tok() const
+	{
+		return Tok::from_kind(next_tok_kind);
+	}
+	inline u8 next_tok_props() const
+	{
+		return tok_props[static_cast<size_t>(next_tok_kind)];
+	}
+
 	inline ParseNode(const ParseNode& to_copy) = default;
 	inline ParseNode(ParseNode&& to_move) = default;
 	inline ParseNode& operator = (const ParseNode& to_copy) = default;
 	inline ParseNode& operator = (ParseNode&& to_move) = default;
 };
 
+// A read-only view of some ParseNodes, so that a line's tokens can be
+// narrowed down (e.g. to skip a label) without copying them.
+class ParseSpan
+{
+private:		// variables
+	const ParseNode* __data = nullptr;
+	size_t __size = 0;
+
+public:		// functions
+	inline ParseSpan()
+	{
+	}
+	inline ParseSpan(const ParseNode* s_data, size_t s_size)
+		: __data(s_data), __size(s_size)
+	{
+	}
+	inline ParseSpan(const std::vector<ParseNode>& some_parse_vec)
+		: __data(some_parse_vec.data()), __size(some_parse_vec.size())
+	{
+	}
+
+	inline ParseSpan(const ParseSpan& to_copy) = default;
+	inline ParseSpan& operator = (const ParseSpan& to_copy) = default;
+
+	inline const ParseNode& at(size_t index) const
+	{
+		if (index >= size())
+		{
+			throw std::out_of_range("ParseSpan::at()");
+		}
+
+		return __data[index];
+	}
+	inline const ParseNode& operator [] (size_t index) const
+	{
+		return __data[index];
+	}
+	inline const ParseNode& front() const
+	{
+		return at(0);
+	}
+	inline const ParseNode& back() const
+	{
+		return at(size() - 1);
+	}
+
+	inline const ParseNode* begin() const
+	{
+		return __data;
+	}
+	inline const ParseNode* end() const
+	{
+		return __data + __size;
+	}
+
+	// The some_count nodes starting at some_offset
+	inline ParseSpan subspan(size_t some_offset, size_t some_count) const
+	{
+		if ((some_offset > size()) || (some_count > (size() - some_offset)))
+		{
+			throw std::out_of_range("ParseSpan::subspan()");
+		}
+
+		return ParseSpan(__data + some_offset, some_count);
+	}
+
+	inline bool empty() const
+	{
+		return (size() == 0);
+	}
+
+	gen_getter_by_val(data)
+	gen_getter_by_val(size)
+};
+
+// One source line's worth of tokens.  Lexing is done only once, and every
+// pass reuses these.  The tokens themselves are all stored one after
+// another in a single vector (see Assembler::__parse_nodes), and a
+// LexedLine just says which of them are its own.
+class LexedLine
+{
+public:		// variables
+	size_t line_num = 0;
+	size_t first_node = 0, num_nodes = 0;
+
+public:		// functions
+	inline LexedLine()
+	{
+	}
+
+	inline LexedLine(size_t s_line_num, size_t s_first_node,
+		size_t s_num_nodes)
+		: line_num(s_line_num), first_node(s_first_node),
+		num_nodes(s_num_nodes)
+	{
+	}
+
+	inline LexedLine(const LexedLine& to_copy) = default;
+	inline LexedLine(LexedLine&& to_move) = default;
+	inline LexedLine& operator = (const LexedLine& to_copy) = default;
+	inline LexedLine& operator = (LexedLine&& to_move) = default;
+};
+
+// Some consecutive lines, as handed from the lexer to the first pass
+class LexedBatch
+{
+public:		// variables
+	// first_node is an index into this batch's parse_nodes
+	std::vector<LexedLine> lexed_lines;
+	std::vector<ParseNode> parse_nodes;
+
+	// .def names seen for the first time, and the index into lexed_lines
+	// of the line each was first seen on
+	std::vector<std::pair<size_t, SymId>> define_names;
+
+	// If lexing stopped at an error, the error message (the batch's lines
+	// are all from before the error)
+	bool error = false;
+	std::string error_msg;
+
+	// Set on the last batch
+	bool last = false;
+
+public:		// functions
+	inline LexedBatch()
+	{
+	}
+
+	inline LexedBatch(const LexedBatch& to_copy) = default;
+	inline LexedBatch(LexedBatch&& to_move) = default;
+	inline LexedBatch& operator = (const LexedBatch& to_copy) = default;
+	inline LexedBatch& operator = (LexedBatch&& to_move) = default;
+
+	// Empties the batch, but keeps its vectors' storage around
+	inline void clear()
+	{
+		lexed_lines.clear();
+		parse_nodes.clear();
+		define_names.clear();
+	}
+};
+
 }
 
 #endif		// parse_node_class_hpp
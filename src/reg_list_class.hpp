@@ -0,0 +1,56 @@
+#ifndef reg_list_class_hpp
+#define reg_list_class_hpp
+
+#include "misc_includes.hpp"
+
+namespace flare32
+{
+
+// The register operands of one instruction, as register numbers, stored
+// inline so that encoding an instruction doesn't need the heap.
+class RegList
+{
+public:		// constants
+	// stmdb rA, {rB, rC, rD, rE, rF, rG, rH, rI}
+	static constexpr size_t max_size = 9;
+
+private:		// variables
+	u8 __regs[max_size];
+	size_t __size = 0;
+
+public:		// functions
+	inline RegList()
+	{
+	}
+
+	inline RegList(const RegList& to_copy) = default;
+	inline RegList& operator = (const RegList& to_copy) = default;
+
+	inline void push_back(s64 to_push)
+	{
+		if (__size >= max_size)
+		{
+			throw std::out_of_range("RegList::push_back()");
+		}
+		__regs[__size++] = to_push;
+	}
+
+	inline u8 at(size_t index) const
+	{
+		if (index >= __size)
+		{
+			throw std::out_of_range("RegList::at()");
+		}
+		return __regs[index];
+	}
+
+	inline size_t size() const
+	{
+		return __size;
+	}
+};
+
+}
+
+
+#endif		// reg_list_class_hpp
@@ -5,7 +5,7 @@
 #include "tokens_and_stuff.hpp"
 #include "instruction_table_class.hpp"
 
-#include "user_ident_table_class.hpp"
+#include "ident_pool_class.hpp"
 
 namespace flare32
 {
@@ -21,27 +21,27 @@ enum class SymType
 class Symbol
 {
 private:		// variables
-	std::string __name;
-	PTok __token;
+	// The interned name
+	SymId __id = IdentPool::bad_id;
+	PTok __token = nullptr;
 
-	s64 __value;
+	s64 __value = 0;
 
-	SymType __type;
+	SymType __type = SymType::Other;
+
+	// Object files only:  whether __value is an address in the section,
+	// which moves when the object file gets linked (labels, and equates
+	// set to them)
+	bool __relocatable = false;
 
 
 public:		// functions
 	inline Symbol()
 	{
 	}
-	inline Symbol(const std::string& s_name, PTok s_token, s64 s_value=0,
+	inline Symbol(SymId s_id, PTok s_token, s64 s_value=0,
 		SymType s_type=SymType::Other) 
-		: __name(s_name), __token(s_token), __value(s_value),
-		__type(s_type)
-	{
-	}
-	inline Symbol(std::string&& s_name, PTok s_token, s64 s_value=0,
-		SymType s_type=SymType::Other)
-		: __name(std::move(s_name)), __token(s_token), __value(s_value),
+		: __id(s_id), __token(s_token), __value(s_value),
 		__type(s_type)
 	{
 	}
@@ -51,14 +51,105 @@ public:		// functions
 	inline Symbol& operator = (const Symbol& to_copy) = default;
 	inline Symbol& operator = (Symbol&& to_move) = default;
 
-	gen_getter_and_setter_by_con_ref(name)
-	gen_setter_by_rval_ref(name)
+	gen_getter_and_setter_by_val(id)
 	gen_getter_and_setter_by_con_ref(token)
 	gen_getter_and_setter_by_val(value)
 	gen_getter_and_setter_by_val(type)
+	gen_getter_and_setter_by_val(relocatable)
 };
 
-typedef UserIdentTable<Symbol> SymbolTable;
+// Symbols looked up directly by their SymId, no hashing needed
+class SymbolTable
+{
+private:		// constants
+	static constexpr size_t no_index = static_cast<size_t>(-1);
+
+private:		// variables
+	// std::deque so that references to symbols stay valid when more are
+	// inserted
+	std::deque<Symbol> __symbols;
+
+	// Maps a SymId to an index into __symbols
+	std::vector<size_t> __index_of_id;
+
+public:		// functions
+	inline SymbolTable()
+	{
+	}
+
+	// Returns nullptr if there's no symbol with the ID some_id
+	inline Symbol* find(SymId some_id)
+	{
+		const size_t index = __find_index(some_id);
+		return (index != no_index) ? &__symbols[index] : nullptr;
+	}
+	inline const Symbol* find(SymId some_id) const
+	{
+		const size_t index = __find_index(some_id);
+		return (index != no_index) ? &__symbols[index] : nullptr;
+	}
+
+	inline Symbol& at(SymId some_id)
+	{
+		Symbol* ret = find(some_id);
+
+		if (ret == nullptr)
+		{
+			throw std::out_of_range("SymbolTable::at()");
+		}
+
+		return *ret;
+	}
+	inline const Symbol& at(SymId some_id) const
+	{
+		const Symbol* ret = find(some_id);
+
+		if (ret == nullptr)
+		{
+			throw std::out_of_range("SymbolTable::at()");
+		}
+
+		return *ret;
+	}
+
+	inline bool contains(SymId some_id) const
+	{
+		return (find(some_id) != nullptr);
+	}
+
+	inline void insert_or_assign(const Symbol& to_insert_or_assign)
+	{
+		insert_or_assign(Symbol(to_insert_or_assign));
+	}
+	inline void insert_or_assign(Symbol&& to_insert_or_assign)
+	{
+		const SymId some_id = to_insert_or_assign.id();
+
+		if (Symbol* existing = find(some_id))
+		{
+			*existing = std::move(to_insert_or_assign);
+			return;
+		}
+
+		if (some_id >= __index_of_id.size())
+		{
+			__index_of_id.resize(some_id + 1, no_index);
+		}
+
+		__index_of_id[some_id] = __symbols.size();
+		__symbols.push_back(std::move(to_insert_or_assign));
+	}
+
+	// In insertion order
+	gen_getter_by_con_ref(symbols);
+
+private:		// functions
+	inline size_t __find_index(SymId some_id) const
+	{
+		return (some_id < __index_of_id.size()) ? __index_of_id[some_id]
+			: no_index;
+	}
+};
 
 }
 
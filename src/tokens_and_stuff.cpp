@@ -4,7 +4,7 @@
 namespace flare32
 {
 
-#define TOKEN_STUFF(varname, value) Tok::varname(value),
+#define TOKEN_STUFF(varname, value) Tok::varname(TokKind::varname, value),
 
 const Tok LIST_OF_TOKENS(TOKEN_STUFF) Tok::Dummy;
 
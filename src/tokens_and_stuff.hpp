@@ -109,6 +109,9 @@ TOKEN_STUFF(DotOrg, ".org") \
 TOKEN_STUFF(DotB, ".db") \
 TOKEN_STUFF(DotW, ".dw") \
 \
+/* Export symbols from an object file */ \
+TOKEN_STUFF(DotGlobal, ".global") \
+\
 LIST_OF_EQUATE_DIRECTIVE_TOKENS(TOKEN_STUFF) \
 \
 /* Defines stuff */ \
@@ -138,6 +141,66 @@ LIST_OF_DIRECTIVE_TOKENS(TOKEN_STUFF)
 namespace flare32
 {
 
+// One per token, in LIST_OF_TOKENS order.  Lim is also used for "no
+// token".
+#define TOKEN_STUFF(varname, value) varname,
+enum class TokKind : u8
+{
+	LIST_OF_TOKENS(TOKEN_STUFF)
+	Lim,
+};
+#undef TOKEN_STUFF
+
+static_assert(static_cast<size_t>(TokKind::Lim) < 0xff,
+	"Too many tokens for TokKind");
+
+static constexpr size_t num_tok_kinds 
+	= static_cast<size_t>(TokKind::Lim) + 1;
+
+// Token properties (bits), so that classifying a token is just one AND
+class TokProp
+{
+public:		// constants
+	static constexpr u8 Punct = 1 << 0;
+	static constexpr u8 Comment = 1 << 1;
+	static constexpr u8 Operator = 1 << 2;
+	static constexpr u8 IdentIsh = 1 << 3;
+	static constexpr u8 Directive = 1 << 4;
+};
+
+constexpr std::array<u8, num_tok_kinds> make_tok_props()
+{
+	std::array<u8, num_tok_kinds> ret{};
+
+	#define PUNCT_STUFF(varname, value) \
+		ret[static_cast<size_t>(TokKind::varname)] |= TokProp::Punct;
+	#define COMMENT_STUFF(varname, value) \
+		ret[static_cast<size_t>(TokKind::varname)] |= TokProp::Comment;
+	#define OPERATOR_STUFF(varname, value) \
+		ret[static_cast<size_t>(TokKind::varname)] |= TokProp::Operator;
+	#define IDENT_ISH_STUFF(varname, value) \
+		ret[static_cast<size_t>(TokKind::varname)] |= TokProp::IdentIsh;
+	#define DIRECTIVE_STUFF(varname, value) \
+		ret[static_cast<size_t>(TokKind::varname)] |= TokProp::Directive;
+
+	LIST_OF_PUNCT_TOKENS(PUNCT_STUFF)
+	LIST_OF_COMMENT_TOKENS(COMMENT_STUFF)
+	LIST_OF_OPERATOR_TOKENS(OPERATOR_STUFF)
+	LIST_OF_IDENT_ISH_TOKENS(IDENT_ISH_STUFF)
+	LIST_OF_DIRECTIVE_TOKENS(DIRECTIVE_STUFF)
+
+	#undef PUNCT_STUFF
+	#undef COMMENT_STUFF
+	#undef OPERATOR_STUFF
+	#undef IDENT_ISH_STUFF
+	#undef DIRECTIVE_STUFF
+
+	return ret;
+}
+
+inline constexpr std::array<u8, num_tok_kinds> tok_props
+	= make_tok_props();
+
 
 class Tok;
 typedef const Tok* PTok;
@@ -148,6 +211,7 @@ class Tok
 {
 private:		// variables
 	std::string __str;
+	TokKind __kind = TokKind::Lim;
 
 public:		// constants
 	//#define VARNAME(some_tok) some_tok,
@@ -170,10 +234,12 @@ public:		// functions
 	inline Tok()
 	{
 	}
-	inline Tok(const std::string& s_str) : __str(s_str)
+	inline Tok(TokKind s_kind, const std::string& s_str) 
+		: __str(s_str), __kind(s_kind)
 	{
 	}
-	inline Tok(std::string&& s_str) : __str(std::move(s_str))
+	inline Tok(TokKind s_kind, std::string&& s_str) 
+		: __str(std::move(s_str)), __kind(s_kind)
 	{
 	}
 
@@ -185,25 +251,45 @@ public:		// functions
 
 	inline bool operator == (const Tok& to_cmp) const
 	{
-		return (str() == to_cmp.str());
+		return (kind() == to_cmp.kind());
 	}
 	inline bool operator != (const Tok& to_cmp) const
 	{
-		return (str() != to_cmp.str());
+		return (kind() != to_cmp.kind());
 	}
 
 	inline bool operator < (const Tok& to_cmp) const
 	{
-		return (str() < to_cmp.str());
+		return (kind() < to_cmp.kind());
+	}
+
+	inline u8 props() const
+	{
+		return tok_props[static_cast<size_t>(kind())];
 	}
 
+	// nullptr for TokKind::Lim
+	static inline PTok from_kind(TokKind some_kind);
+
 	gen_getter_by_con_ref(str)
+	gen_getter_by_val(kind)
 
 	gen_setter_by_con_ref(str)
 	gen_setter_by_rval_ref(str)
 
 };
 
+// Indexed by TokKind
+#define TOKEN_STUFF(varname, value) &Tok::varname,
+inline constexpr PTok tok_ptrs[num_tok_kinds] 
+	= {LIST_OF_TOKENS(TOKEN_STUFF) nullptr};
+#undef TOKEN_STUFF
+
+inline PTok Tok::from_kind(TokKind some_kind)
+{
+	return tok_ptrs[static_cast<size_t>(some_kind)];
+}
+
 }
 
 
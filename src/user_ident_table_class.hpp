@@ -10,43 +10,182 @@
 namespace flare32
 {
 
+// Open addressing (linear probing) hash table of things that have a
+// name(), looked up by std::string_view.  Lookups never insert anything.
 template<typename Type>
 class UserIdentTable
 {
+private:		// constants
+	static constexpr size_t empty_index = static_cast<size_t>(-1);
+	static constexpr size_t min_num_slots = 64;
+
+private:		// classes
+	class Slot
+	{
+	public:		// variables
+		size_t hash = 0;
+
+		// Index into __entries, or empty_index if this slot is unused
+		size_t index = empty_index;
+	};
+
 private:		// variables
-	std::map<std::string, Type> __table;
+	// std::deque so that references to entries stay valid when more are
+	// inserted (just like they did with std::map)
+	std::deque<Type> __entries;
+
+	// Always a power of two in size, and never more than half full
+	std::vector<Slot> __slots;
 
 public:		// functions
 	inline UserIdentTable()
 	{
 	}
 
+	// Returns nullptr if there's nothing named some_name
+	inline Type* find(std::string_view some_name)
+	{
+		const size_t index = __find_index(some_name);
+		return (index != empty_index) ? &__entries[index] : nullptr;
+	}
+	inline const Type* find(std::string_view some_name) const
+	{
+		const size_t index = __find_index(some_name);
+		return (index != empty_index) ? &__entries[index] : nullptr;
+	}
+
 	// Type accessors
-	inline Type& at(const std::string& some_name)
+	inline Type& at(std::string_view some_name)
 	{
-		return __table[some_name];
+		Type* ret = find(some_name);
+
+		if (ret == nullptr)
+		{
+			throw std::out_of_range("UserIdentTable::at()");
+		}
+
+		return *ret;
 	}
 
-	inline const Type& at(const std::string& some_name) const
+	inline const Type& at(std::string_view some_name) const
 	{
-		return __table.at(some_name);
+		const Type* ret = find(some_name);
+
+		if (ret == nullptr)
+		{
+			throw std::out_of_range("UserIdentTable::at()");
+		}
+
+		return *ret;
 	}
 
-	inline bool contains(const std::string& some_name) const
+	inline bool contains(std::string_view some_name) const
 	{
-		return (__table.count(some_name) == 1);
+		return (find(some_name) != nullptr);
 	}
 
 	inline void insert_or_assign(const Type& to_insert_or_assign)
 	{
-		at(to_insert_or_assign.name()) = to_insert_or_assign;
+		Type* existing = find(to_insert_or_assign.name());
+
+		if (existing != nullptr)
+		{
+			*existing = to_insert_or_assign;
+		}
+		else
+		{
+			__insert(Type(to_insert_or_assign));
+		}
 	}
 	inline void insert_or_assign(Type&& to_insert_or_assign)
 	{
-		at(to_insert_or_assign.name()) = std::move(to_insert_or_assign);
+		Type* existing = find(to_insert_or_assign.name());
+
+		if (existing != nullptr)
+		{
+			*existing = std::move(to_insert_or_assign);
+		}
+		else
+		{
+			__insert(std::move(to_insert_or_assign));
+		}
+	}
+
+	// In insertion order
+	gen_getter_by_con_ref(entries);
+
+private:		// functions
+	static inline size_t __hash(std::string_view some_name)
+	{
+		return std::hash<std::string_view>()(some_name);
 	}
 
-	gen_getter_by_con_ref(table);
+	inline size_t __find_index(std::string_view some_name) const
+	{
+		if (__slots.size() == 0)
+		{
+			return empty_index;
+		}
+
+		const size_t some_hash = __hash(some_name);
+		const size_t mask = __slots.size() - 1;
+
+		for (size_t i=some_hash & mask; ; i=(i + 1) & mask)
+		{
+			const Slot& slot = __slots[i];
+
+			if (slot.index == empty_index)
+			{
+				return empty_index;
+			}
+
+			if ((slot.hash == some_hash)
+				&& (__entries[slot.index].name() == some_name))
+			{
+				return slot.index;
+			}
+		}
+	}
+
+	inline void __insert(Type&& to_insert)
+	{
+		if (((__entries.size() + 1) * 2) > __slots.size())
+		{
+			__rehash(std::max(min_num_slots, __slots.size() * 2));
+		}
+
+		const size_t some_hash = __hash(to_insert.name());
+		__entries.push_back(std::move(to_insert));
+		__place(some_hash, __entries.size() - 1);
+	}
+
+	inline void __place(size_t some_hash, size_t index)
+	{
+		const size_t mask = __slots.size() - 1;
+		size_t i = some_hash & mask;
+
+		while (__slots[i].index != empty_index)
+		{
+			i = (i + 1) & mask;
+		}
+
+		__slots[i].hash = some_hash;
+		__slots[i].index = index;
+	}
+
+	inline void __rehash(size_t num_slots)
+	{
+		std::vector<Slot> old_slots(num_slots);
+		__slots.swap(old_slots);
+
+		for (const auto& slot : old_slots)
+		{
+			if (slot.index != empty_index)
+			{
+				__place(slot.hash, slot.index);
+			}
+		}
+	}
 };
 
 }
@@ -14,28 +14,59 @@ namespace flare32
 
 class WarnError
 {
+public:		// classes
+	// Thrown instead of exiting when errors are deferred
+	class Deferred
+	{
+	};
+
 private:		// variables
 	size_t* __line_num = nullptr;
 
+	// When set, error messages go into __deferred_msg, and Deferred is
+	// thrown instead of exiting, so that another thread can decide what
+	// to do with the error
+	bool __defer = false;
+	mutable std::ostringstream __deferred_msg;
+
 
 public:		// functions
 	inline WarnError(size_t* s_line_num)
 		: __line_num(s_line_num)
 	{
 	}
+
+	// Where error messages go
+	inline std::ostream& os() const
+	{
+		if (__defer)
+		{
+			return __deferred_msg;
+		}
+		return std::cerr;
+	}
+
 	template<typename... ArgTypes>
 	void err_suffix(ArgTypes&&... args) const
 	{
-		printerr(", On line ", line_num(), ":  ", args..., "\n");
-		exit(1);
+		osprintout(os(), ", On line ", line_num(), ":  ", args..., "\n");
+		stop();
 	}
 	template<typename... ArgTypes>
 	void err(ArgTypes&&... args) const
 	{
-		printerr("Error");
+		osprintout(os(), "Error");
 		err_suffix(args...);
 	}
 
+	// Prints args exactly as they are, then stops like err() does
+	template<typename... ArgTypes>
+	void fail(ArgTypes&&... args) const
+	{
+		osprintout(os(), args...);
+		stop();
+	}
+
 	template<typename... ArgTypes>
 	void expected(ArgTypes&&... args) const
 	{
@@ -50,11 +81,11 @@ public:		// functions
 	void __expected_tokens_innards(PTok tok, RemArgTypes&&... rem_args)
 		const
 	{
-		printerr("\"", tok->str(), "\"");
+		osprintout(os(), "\"", tok->str(), "\"");
 
 		if (sizeof...(rem_args) > 0)
 		{
-			printerr(" or ");
+			osprintout(os(), " or ");
 			__expected_tokens_innards(rem_args...);
 		}
 	}
@@ -62,15 +93,41 @@ public:		// functions
 	template<typename... ArgTypes>
 	void expected_tokens(ArgTypes&&... args) const
 	{
-		printerr("Error, On line ", line_num(), ":  ");
-		printerr("Expected token of type ");
+		osprintout(os(), "Error, On line ", line_num(), ":  ");
+		osprintout(os(), "Expected token of type ");
 		__expected_tokens_innards(args...);
-		printerr("!\n");
-		exit(1);
+		osprintout(os(), "!\n");
+		stop();
+	}
+
+	inline void defer()
+	{
+		__defer = true;
+	}
+
+	// Returns whether errors were deferred before
+	inline bool set_defer(bool n_defer)
+	{
+		const bool ret = __defer;
+		__defer = n_defer;
+		return ret;
+	}
+	inline std::string deferred_msg() const
+	{
+		return __deferred_msg.str();
 	}
 
 
 private:		// functions
+	[[noreturn]] inline void stop() const
+	{
+		if (__defer)
+		{
+			throw Deferred();
+		}
+		exit(1);
+	}
+
 	inline size_t line_num() const
 	{
 		return *__line_num;
@@ -0,0 +1,118 @@
+#ifndef work_stealing_pool_class_hpp
+#define work_stealing_pool_class_hpp
+
+#include "misc_includes.hpp"
+
+namespace flare32
+{
+
+// Runs a fixed number of independent tasks, numbered from 0, on a fixed
+// number of threads.  Each thread starts out with its own share of the
+// tasks.  It runs those from the back of its own deque, and once it has
+// run out, it steals from the front of another thread's deque, so that
+// one slow task doesn't leave the other threads idle.
+class WorkStealingPool
+{
+private:		// classes
+	class Worker
+	{
+	public:		// variables
+		std::mutex mutex;
+		std::deque<size_t> tasks;
+	};
+
+private:		// variables
+	size_t __num_threads = 1;
+
+public:		// functions
+	inline WorkStealingPool(size_t s_num_threads)
+		: __num_threads(std::max(s_num_threads, static_cast<size_t>(1)))
+	{
+	}
+
+	// Returns once every task has been run.  The calling thread is one of
+	// the threads.
+	inline void run(size_t some_num_tasks,
+		const std::function<void(size_t)>& some_run_task)
+	{
+		const size_t num_threads = std::min(__num_threads,
+			std::max(some_num_tasks, static_cast<size_t>(1)));
+
+		// std::deque because a std::mutex can't be moved
+		std::deque<Worker> workers(num_threads);
+
+		for (size_t i=0; i<some_num_tasks; ++i)
+		{
+			workers[(i * num_threads) / some_num_tasks].tasks.push_back(i);
+		}
+
+		auto work = [&](size_t some_worker_index) -> void
+		{
+			size_t task;
+
+			while (__pop(workers, some_worker_index, task)
+				|| __steal(workers, some_worker_index, task))
+			{
+				some_run_task(task);
+			}
+		};
+
+		std::vector<std::thread> threads;
+
+		for (size_t i=1; i<num_threads; ++i)
+		{
+			threads.push_back(std::thread(work, i));
+		}
+
+		work(0);
+
+		for (auto& thread : threads)
+		{
+			thread.join();
+		}
+	}
+
+private:		// functions
+	static inline bool __pop(std::deque<Worker>& workers,
+		size_t some_worker_index, size_t& ret)
+	{
+		Worker& worker = workers[some_worker_index];
+		std::lock_guard<std::mutex> lock(worker.mutex);
+
+		if (worker.tasks.empty())
+		{
+			return false;
+		}
+
+		ret = worker.tasks.back();
+		worker.tasks.pop_back();
+		return true;
+	}
+
+	// No tasks are ever added once run() has started, so if every other
+	// worker's deque is empty, there's nothing left to steal.
+	static inline bool __steal(std::deque<Worker>& workers,
+		size_t some_thief_index, size_t& ret)
+	{
+		for (size_t i=1; i<workers.size(); ++i)
+		{
+			Worker& victim = workers[(some_thief_index + i) 
+				% workers.size()];
+			std::lock_guard<std::mutex> lock(victim.mutex);
+
+			if (!victim.tasks.empty())
+			{
+				ret = victim.tasks.front();
+				victim.tasks.pop_front();
+				return true;
+			}
+		}
+
+		return false;
+	}
+};
+
+}
+
+
+#endif		// work_stealing_pool_class_hpp